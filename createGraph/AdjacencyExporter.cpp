@@ -0,0 +1,570 @@
+#include <omp.h>
+#include <charconv>
+#include <cstring>
+
+#include "AdjacencyExporter.h"
+#include "Network.h"
+#include "GraphStore.h"
+#include "Link.h"
+#include "Node.h"
+#include "Road.h"
+#include "Profiler.h"
+
+namespace
+{
+    const bool isLittleEndianHost = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+    /*! Stores the bytes of a value at out, least significant first, whatever the byte order of the machine */
+    template <typename T>
+    void storeLittleEndian(T value, char* out)
+    {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (size_t b = 0; b < sizeof(T); b++)
+        {
+            out[b] = static_cast<char>(isLittleEndianHost ? bytes[b] : bytes[sizeof(T) - 1 - b]);
+        }
+    }
+
+    /*! The bytes of an array in little-endian order: the array itself on a little-endian machine, else a converted copy in storage */
+    template <typename T>
+    const char* littleEndianBytes(const T* data, size_t count, std::vector<char>& storage)
+    {
+        if (isLittleEndianHost)
+        {
+            return reinterpret_cast<const char*>(data);
+        }
+        storage.resize(count * sizeof(T));
+        for (size_t i = 0; i < count; i++)
+        {
+            storeLittleEndian(data[i], storage.data() + i * sizeof(T));
+        }
+        return storage.data();
+    }
+
+    /*! Writes a file through a large buffer, so that a matrix of millions of rows costs a few hundred write calls */
+    class BufferedWriter
+    {
+        static const size_t bufferSize = 1 << 20;
+        std::ofstream out;
+        std::string buffer;
+    public:
+        BufferedWriter(const std::string& filename) : out(filename, std::ios::binary)
+        {
+            buffer.reserve(bufferSize);
+        }
+
+        bool isOpen() const
+        {
+            return out.is_open();
+        }
+
+        void append(const char* data, size_t size)
+        {
+            if (buffer.size() + size > bufferSize)
+            {
+                flush();
+            }
+            if (size >= bufferSize)
+            {
+                out.write(data, size);
+            }
+            else
+            {
+                buffer.append(data, size);
+            }
+        }
+
+        void append(const std::string& text)
+        {
+            append(text.data(), text.size());
+        }
+
+        void append(char c)
+        {
+            if (buffer.size() == bufferSize)
+            {
+                flush();
+            }
+            buffer.push_back(c);
+        }
+
+        template <typename T>
+        void appendNumber(T value)
+        {
+            char digits[24];
+            std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+            append(digits, result.ptr - digits);
+        }
+
+        /*! Appends the bytes of a value, little-endian */
+        template <typename T>
+        void appendRaw(T value)
+        {
+            char bytes[sizeof(T)];
+            storeLittleEndian(value, bytes);
+            append(bytes, sizeof(T));
+        }
+
+        /*! Appends the bytes of an array, little-endian */
+        template <typename T>
+        void appendArray(const std::vector<T>& values)
+        {
+            std::vector<char> storage;
+            append(littleEndianBytes(values.data(), values.size(), storage), values.size() * sizeof(T));
+        }
+
+        void flush()
+        {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        /*! @return false if a write failed */
+        bool close()
+        {
+            flush();
+            out.close();
+            return !out.fail();
+        }
+    };
+
+    /*! The CRC-32 of zip files (polynomial 0xEDB88320), continued from crc */
+    uint32_t updateCRC32(uint32_t crc, const char* data, size_t size)
+    {
+        static const std::vector<uint32_t> table = []()
+        {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    /*! The header of a .npy file (version 1.0), padded so that the data starts at a multiple of 64 bytes */
+    std::string npyHeader(const std::string& descr, const std::string& shape)
+    {
+        std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+        size_t length = 10 + dict.size() + 1;
+        dict.append((64 - length % 64) % 64, ' ');
+        dict.push_back('\n');
+        std::string header = "\x93NUMPY";
+        header.push_back(1);
+        header.push_back(0);
+        header.push_back(static_cast<char>(dict.size() & 0xFF));
+        header.push_back(static_cast<char>(dict.size() >> 8));
+        return header + dict;
+    }
+
+    /*! A member of a .npz archive: an array stored uncompressed as name.npy */
+    struct NpyMember
+    {
+        std::string name;
+        std::string header;
+        const char* data;
+        size_t size;
+    };
+}
+
+AdjacencyExporter::AdjacencyExporter() : network(nullptr), ofRoads(false)
+{
+}
+
+AdjacencyExporter::AdjacencyExporter(Network* _network) : network(_network), ofRoads(false)
+{
+}
+
+AdjacencyExporter::~AdjacencyExporter()
+{
+}
+
+void AdjacencyExporter::buildRows(int numOfRows, int numThreads, const std::function<void(int, std::vector<int>&)>& collectRow)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    offsets.assign(numOfRows + 1, 0);
+#pragma omp parallel num_threads(numThreads)
+    {
+        std::vector<int> row;
+#pragma omp for schedule(dynamic, 1024)
+        for (int i = 0; i < numOfRows; i++)
+        {
+            collectRow(i, row);
+            offsets[i + 1] = row.size();
+        }
+#pragma omp single
+        {
+            for (int i = 0; i < numOfRows; i++)
+            {
+                offsets[i + 1] += offsets[i];
+            }
+            columns.resize(offsets[numOfRows]);
+        }
+#pragma omp for schedule(dynamic, 1024)
+        for (int i = 0; i < numOfRows; i++)
+        {
+            collectRow(i, row);
+            std::copy(row.begin(), row.end(), columns.begin() + offsets[i]);
+        }
+    }
+}
+
+void AdjacencyExporter::buildLinkAdjacency(int numThreads)
+{
+    PROFILE_PHASE(phase, "AdjacencyExporter::buildLinkAdjacency");
+    GraphStore* store = network->getGraphStore();
+    int numOfLinks = static_cast<int>(store->getNumOfLinks());
+    ofRoads = false;
+    ids.resize(numOfLinks);
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        ids[i] = store->getLinkID(i);
+    }
+
+    // The union of the four neighbour lists of a link, ascending
+    buildRows(numOfLinks, numThreads, [store](int link, std::vector<int>& row)
+    {
+        row.clear();
+        for (int list = 0; list < GraphStore::numOfNeighbourLists; list++)
+        {
+            LinkRange neighbours = store->getNeighbourLinks(link, list);
+            for (size_t n = 0; n < neighbours.size(); n++)
+            {
+                row.push_back(neighbours.indexAt(n));
+            }
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    });
+    PROFILE_COUNT(phase, "rows", ids.size());
+    PROFILE_COUNT(phase, "nonZeros", columns.size());
+}
+
+void AdjacencyExporter::buildRoadAdjacency(const std::vector<int>* linkOfVDS, int numThreads)
+{
+    PROFILE_PHASE(phase, "AdjacencyExporter::buildRoadAdjacency");
+    GraphStore* store = network->getGraphStore();
+    RoadMap* roads = network->getRoads();
+    int numOfRoads = static_cast<int>(roads->size());
+    int numOfNodes = static_cast<int>(store->getNumOfNodes());
+    ofRoads = true;
+
+    // The rows: every road, or the roads of the matched VDS, in road ID order
+    std::vector<bool> kept(numOfRoads, linkOfVDS == nullptr);
+    if (linkOfVDS != nullptr)
+    {
+        for (int link : *linkOfVDS)
+        {
+            Road* road = (link != -1) ? store->getLinkRoad(link) : nullptr;
+            if (road != nullptr)
+            {
+                kept[roads->indexOf(road->getID())] = true;
+            }
+        }
+    }
+    ids.clear();
+    std::vector<int> startNodes;
+    std::vector<int> endNodes;
+    for (int r = 0; r < numOfRoads; r++)
+    {
+        if (kept[r])
+        {
+            Road* road = roads->at(r);
+            ids.push_back(road->getID());
+            startNodes.push_back(road->getStartNode()->getIndex());
+            endNodes.push_back(road->getEndNode()->getIndex());
+        }
+    }
+    int numOfRows = static_cast<int>(ids.size());
+
+    // The rows at every node, ascending, as a CSR array over the nodes; a closed road is at its node once
+    std::vector<int> rowOffsets(numOfNodes + 1, 0);
+    for (int i = 0; i < numOfRows; i++)
+    {
+        rowOffsets[startNodes[i] + 1]++;
+        if (endNodes[i] != startNodes[i])
+        {
+            rowOffsets[endNodes[i] + 1]++;
+        }
+    }
+    std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+    std::vector<int> rowsAtNodes(rowOffsets[numOfNodes]);
+    std::vector<int> next(rowOffsets.begin(), rowOffsets.end() - 1);
+    for (int i = 0; i < numOfRows; i++)
+    {
+        rowsAtNodes[next[startNodes[i]]++] = i;
+        if (endNodes[i] != startNodes[i])
+        {
+            rowsAtNodes[next[endNodes[i]]++] = i;
+        }
+    }
+
+    // The rows at the start and end nodes of a road, except the road itself
+    buildRows(numOfRows, numThreads, [&](int i, std::vector<int>& row)
+    {
+        row.clear();
+        for (int node : {startNodes[i], endNodes[i]})
+        {
+            for (int k = rowOffsets[node]; k < rowOffsets[node + 1]; k++)
+            {
+                if (rowsAtNodes[k] != i)
+                {
+                    row.push_back(rowsAtNodes[k]);
+                }
+            }
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    });
+    PROFILE_COUNT(phase, "rows", ids.size());
+    PROFILE_COUNT(phase, "nonZeros", columns.size());
+}
+
+size_t AdjacencyExporter::getNumOfRows() const
+{
+    return ids.size();
+}
+
+size_t AdjacencyExporter::getNumOfNonZeros() const
+{
+    return columns.size();
+}
+
+bool AdjacencyExporter::write(const std::string& filename, AdjacencyFormat format) const
+{
+    PROFILE_PHASE(phase, "AdjacencyExporter::write");
+    switch (format)
+    {
+        case csvAdjacency:
+            return writeCSV(filename);
+        case csrAdjacency:
+            return writeCSR(filename);
+        case npzAdjacency:
+            return writeNPZ(filename);
+        case matrixMarketAdjacency:
+            return writeMatrixMarket(filename);
+    }
+    return false;
+}
+
+bool AdjacencyExporter::parseFormat(const std::string& name, AdjacencyFormat& format)
+{
+    if (name == "csv") format = csvAdjacency;
+    else if (name == "csr") format = csrAdjacency;
+    else if (name == "npz") format = npzAdjacency;
+    else if (name == "mtx") format = matrixMarketAdjacency;
+    else return false;
+    return true;
+}
+
+bool AdjacencyExporter::writeCSV(const std::string& filename) const
+{
+    BufferedWriter out(filename);
+    if (!out.isOpen())
+    {
+        return false;
+    }
+    if (ofRoads)
+    {
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            out.appendNumber(ids[i]);
+            out.append(',');
+            out.appendNumber(offsets[i + 1] - offsets[i]);
+            for (int64_t j = offsets[i]; j < offsets[i + 1]; j++)
+            {
+                out.append(',');
+                out.appendNumber(ids[columns[j]]);
+            }
+            out.append('\n');
+        }
+        return out.close();
+    }
+    // The lists themselves rather than the matrix, as the format keeps their order and their duplicates
+    GraphStore* store = network->getGraphStore();
+    int numOfLinks = static_cast<int>(store->getNumOfLinks());
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        LinkRange lists[GraphStore::numOfNeighbourLists];
+        for (int list = 0; list < GraphStore::numOfNeighbourLists; list++)
+        {
+            lists[list] = store->getNeighbourLinks(i, list);
+        }
+        out.appendNumber(store->getLinkID(i));
+        out.append(',');
+        out.appendNumber(lists[0].size() + lists[1].size());
+        out.append(',');
+        out.appendNumber(lists[2].size() + lists[3].size());
+        for (const LinkRange& list : lists)
+        {
+            for (Link* link : list)
+            {
+                out.append(',');
+                out.appendNumber(link->getID());
+            }
+        }
+        out.append('\n');
+    }
+    return out.close();
+}
+
+bool AdjacencyExporter::writeCSR(const std::string& filename) const
+{
+    BufferedWriter out(filename);
+    if (!out.isOpen())
+    {
+        return false;
+    }
+    out.append("ADJCSR01", 8);
+    out.appendRaw(static_cast<uint64_t>(ids.size()));
+    out.appendRaw(static_cast<uint64_t>(columns.size()));
+    out.appendArray(ids);
+    out.appendArray(offsets);
+    out.appendArray(columns);
+    return out.close();
+}
+
+bool AdjacencyExporter::writeNPZ(const std::string& filename) const
+{
+    // The rows of the non-zeros, and their values, all 1
+    std::vector<int> rows(columns.size());
+    for (size_t i = 0; i + 1 < offsets.size(); i++)
+    {
+        std::fill(rows.begin() + offsets[i], rows.begin() + offsets[i + 1], static_cast<int>(i));
+    }
+    std::vector<float> data(columns.size(), 1.0f);
+    int64_t shape[2] = {static_cast<int64_t>(ids.size()), static_cast<int64_t>(ids.size())};
+    std::string nonZeros = "(" + std::to_string(columns.size()) + ",)";
+
+    // The arrays are declared little-endian ('<') in their headers, and converted on a big-endian machine
+    std::vector<char> storage[5];
+    std::vector<NpyMember> members = {
+        {"format.npy", npyHeader("|S3", "()"), "coo", 3},
+        {"shape.npy", npyHeader("<i8", "(2,)"), littleEndianBytes(shape, 2, storage[0]), sizeof(shape)},
+        {"row.npy", npyHeader("<i4", nonZeros), littleEndianBytes(rows.data(), rows.size(), storage[1]), rows.size() * sizeof(int)},
+        {"col.npy", npyHeader("<i4", nonZeros), littleEndianBytes(columns.data(), columns.size(), storage[2]), columns.size() * sizeof(int)},
+        {"data.npy", npyHeader("<f4", nonZeros), littleEndianBytes(data.data(), data.size(), storage[3]), data.size() * sizeof(float)},
+        {"ids.npy", npyHeader("<i4", "(" + std::to_string(ids.size()) + ",)"), littleEndianBytes(ids.data(), ids.size(), storage[4]), ids.size() * sizeof(int)}};
+
+    // A stored (uncompressed) zip archive, as numpy.savez() writes it; without ZIP64 it is limited to 4 GiB
+    uint64_t archiveSize = 22;
+    for (const NpyMember& member : members)
+    {
+        archiveSize += 30 + 46 + 2 * member.name.size() + member.header.size() + member.size;
+    }
+    if (archiveSize > 0xFFFFFFFFu)
+    {
+        return false;
+    }
+
+    BufferedWriter out(filename);
+    if (!out.isOpen())
+    {
+        return false;
+    }
+    // The times of the members are 1980-01-01 00:00, so that the same matrix gives the same file
+    const uint16_t time = 0;
+    const uint16_t date = (1 << 5) | 1;
+    std::vector<uint32_t> crcs;
+    std::vector<uint32_t> localOffsets;
+    uint32_t offset = 0;
+    for (const NpyMember& member : members)
+    {
+        uint32_t crc = updateCRC32(0, member.header.data(), member.header.size());
+        crc = updateCRC32(crc, member.data, member.size);
+        uint32_t size = static_cast<uint32_t>(member.header.size() + member.size);
+        crcs.push_back(crc);
+        localOffsets.push_back(offset);
+        out.appendRaw(static_cast<uint32_t>(0x04034b50));
+        out.appendRaw(static_cast<uint16_t>(20));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(time);
+        out.appendRaw(date);
+        out.appendRaw(crc);
+        out.appendRaw(size);
+        out.appendRaw(size);
+        out.appendRaw(static_cast<uint16_t>(member.name.size()));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.append(member.name);
+        out.append(member.header);
+        out.append(member.data, member.size);
+        offset += 30 + member.name.size() + size;
+    }
+    uint32_t centralDirectoryOffset = offset;
+    for (size_t m = 0; m < members.size(); m++)
+    {
+        const NpyMember& member = members[m];
+        uint32_t size = static_cast<uint32_t>(member.header.size() + member.size);
+        out.appendRaw(static_cast<uint32_t>(0x02014b50));
+        out.appendRaw(static_cast<uint16_t>(20));
+        out.appendRaw(static_cast<uint16_t>(20));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(time);
+        out.appendRaw(date);
+        out.appendRaw(crcs[m]);
+        out.appendRaw(size);
+        out.appendRaw(size);
+        out.appendRaw(static_cast<uint16_t>(member.name.size()));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint16_t>(0));
+        out.appendRaw(static_cast<uint32_t>(0));
+        out.appendRaw(localOffsets[m]);
+        out.append(member.name);
+        offset += 46 + member.name.size();
+    }
+    out.appendRaw(static_cast<uint32_t>(0x06054b50));
+    out.appendRaw(static_cast<uint16_t>(0));
+    out.appendRaw(static_cast<uint16_t>(0));
+    out.appendRaw(static_cast<uint16_t>(members.size()));
+    out.appendRaw(static_cast<uint16_t>(members.size()));
+    out.appendRaw(offset - centralDirectoryOffset);
+    out.appendRaw(centralDirectoryOffset);
+    out.appendRaw(static_cast<uint16_t>(0));
+    return out.close();
+}
+
+bool AdjacencyExporter::writeMatrixMarket(const std::string& filename) const
+{
+    BufferedWriter out(filename);
+    if (!out.isOpen())
+    {
+        return false;
+    }
+    out.append("%%MatrixMarket matrix coordinate pattern general\n");
+    out.appendNumber(ids.size());
+    out.append(' ');
+    out.appendNumber(ids.size());
+    out.append(' ');
+    out.appendNumber(columns.size());
+    out.append('\n');
+    for (size_t i = 0; i + 1 < offsets.size(); i++)
+    {
+        for (int64_t j = offsets[i]; j < offsets[i + 1]; j++)
+        {
+            out.appendNumber(i + 1);
+            out.append(' ');
+            out.appendNumber(columns[j] + 1);
+            out.append('\n');
+        }
+    }
+    return out.close();
+}
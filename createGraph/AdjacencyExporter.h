@@ -0,0 +1,80 @@
+#ifndef ADJACENCYEXPORTER_H
+#define ADJACENCYEXPORTER_H
+
+#include "DataTypes.h"
+
+#include <functional>
+
+class Network;
+
+/*! This class writes the adjacency of the links or of the roads of a network, for the graph of the GCNN.
+ *  Link j is adjacent to link i if it is one of the before or after links of i, i.e. if the two links share
+ *  a node; road j is adjacent to road i if they share their start or end node (the line graph of the roads,
+ *  which is what the VDS are matched to). The matrix is symmetric, with rows and columns in ID order.
+ *
+ *  The matrix is built once in compressed sparse row form, in parallel over its rows, and then written in
+ *  one of these formats, through large buffered writes:
+ *  - csv: for links, the original text format, one line per link with its ID, its numbers of before and after
+ *    links and the IDs of its before-in, before-out, after-in and after-out links (a link may appear twice);
+ *    for roads, one line per road with its ID, its number of adjacent roads and their IDs;
+ *  - csr: binary, little-endian on every machine: the magic "ADJCSR01", the number of rows and of non-zeros (uint64), the
+ *    IDs of the rows (int32[rows]), the row offsets (int64[rows + 1]) and the columns (int32[non-zeros]);
+ *    every non-zero is 1. With numpy, np.fromfile() at the offsets of the arrays reads it in one go;
+ *  - npz: a zip archive in the format of scipy.sparse.save_npz() for a COO matrix ("format", "shape",
+ *    "row", "col" and float32 "data"), readable by scipy.sparse.load_npz(), plus the IDs of the rows as "ids";
+ *  - mtx: MatrixMarket coordinate pattern, readable by scipy.io.mmread(), 1-based as the format requires.
+ */
+class AdjacencyExporter
+{
+    Network* network;
+    /*! Whether the rows are roads rather than links */
+    bool ofRoads;
+    /*! The external IDs of the rows */
+    std::vector<int> ids;
+    /*! The columns of row i are columns[offsets[i] .. offsets[i + 1]), ascending and each once */
+    std::vector<int64_t> offsets;
+    std::vector<int> columns;
+
+    /*! Fills offsets and columns from the rows given by collectRow(row, columns of the row), in parallel */
+    void buildRows(int numOfRows, int numThreads, const std::function<void(int, std::vector<int>&)>& collectRow);
+    bool writeCSV(const std::string& filename) const;
+    bool writeCSR(const std::string& filename) const;
+    bool writeNPZ(const std::string& filename) const;
+    bool writeMatrixMarket(const std::string& filename) const;
+public:
+    /*! Default constructor */
+    AdjacencyExporter();
+    /*! Constructor */
+    AdjacencyExporter(Network* _network);
+    /*! Destructor */
+    ~AdjacencyExporter();
+
+    /*! Builds the matrix of the links, from the neighbour lists of the GraphStore
+     *  @param numThreads the number of OpenMP threads, 0 means the OpenMP default
+     */
+    void buildLinkAdjacency(int numThreads = 0);
+    /*! Builds the matrix of the roads, from the start and end nodes of the roads
+     *  @param linkOfVDS if given, the dense index of the link of every VDS (-1 if it has not been matched); only
+     *  the roads with at least one matched VDS are kept then, adjacent if they share a node
+     *  @param numThreads the number of OpenMP threads, 0 means the OpenMP default
+     */
+    void buildRoadAdjacency(const std::vector<int>* linkOfVDS = nullptr, int numThreads = 0);
+
+    /*! Setters - Getters */
+    size_t getNumOfRows() const;
+    size_t getNumOfNonZeros() const;
+
+    /*! Writes the matrix
+     *  @param filename the file to write
+     *  @param format the format of the file
+     *  @return false if the file cannot be written
+     */
+    bool write(const std::string& filename, AdjacencyFormat format) const;
+
+    /*! Parses the name of a format: "csv", "csr", "npz" or "mtx"
+     *  @return false if the name is unknown
+     */
+    static bool parseFormat(const std::string& name, AdjacencyFormat& format);
+};
+
+#endif  //  ADJACENCYEXPORTER_H
@@ -0,0 +1,149 @@
+#include "CSVParser.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+	/*! std::stoi/std::stod accept leading blanks and a '+' sign, std::from_chars does not */
+	const char* skipBlanks(const char* p, const char* lineEnd)
+	{
+		while (p < lineEnd && (*p == ' ' || *p == '\t'))
+		{
+			++p;
+		}
+		if (p < lineEnd && *p == '+')
+		{
+			++p;
+		}
+		return p;
+	}
+
+	/*! Moves p after the next separator, or to the end of the line if this was the last field */
+	const char* skipToNextField(const char* p, const char* lineEnd)
+	{
+		const char* comma = static_cast<const char*>(std::memchr(p, ',', lineEnd - p));
+		return (comma != nullptr) ? comma + 1 : lineEnd;
+	}
+
+	template <typename T>
+	bool parseNumber(const char*& p, const char* lineEnd, T& value)
+	{
+		const char* first = skipBlanks(p, lineEnd);
+		std::from_chars_result result = std::from_chars(first, lineEnd, value);
+		if (result.ec != std::errc())
+		{
+			return false;
+		}
+		p = skipToNextField(result.ptr, lineEnd);
+		return true;
+	}
+
+	const char* findLineEnd(const char* p, const char* end)
+	{
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return (newline != nullptr) ? newline : end;
+	}
+}
+
+const char* csv::skipLine(const char* p, const char* end)
+{
+	const char* lineEnd = findLineEnd(p, end);
+	return (lineEnd < end) ? lineEnd + 1 : end;
+}
+
+bool csv::parseField(const char*& p, const char* lineEnd, int& value)
+{
+	return parseNumber(p, lineEnd, value);
+}
+
+bool csv::parseField(const char*& p, const char* lineEnd, double& value)
+{
+	return parseNumber(p, lineEnd, value);
+}
+
+bool csv::parseLinkRecord(const char*& p, const char* end, LinkRecord& record)
+{
+	const char* lineEnd = findLineEnd(p, end);
+	const char* q = p;
+	p = (lineEnd < end) ? lineEnd + 1 : end;
+	return parseField(q, lineEnd, record.linkID)
+		&& parseField(q, lineEnd, record.startNodeID)
+		&& parseField(q, lineEnd, record.startNodeLon)
+		&& parseField(q, lineEnd, record.startNodeLat)
+		&& parseField(q, lineEnd, record.endNodeID)
+		&& parseField(q, lineEnd, record.endNodeLon)
+		&& parseField(q, lineEnd, record.endNodeLat);
+}
+
+bool csv::parseVDSRecord(const char*& p, const char* end, VDSRecord& record)
+{
+	const char* lineEnd = findLineEnd(p, end);
+	const char* q = p;
+	p = (lineEnd < end) ? lineEnd + 1 : end;
+	return parseField(q, lineEnd, record.vdsID)
+		&& parseField(q, lineEnd, record.lat)
+		&& parseField(q, lineEnd, record.lon);
+}
+
+std::vector< std::pair<const char*, const char*> > csv::splitLines(const char* begin, const char* end, int numOfChunks, size_t minChunkSize)
+{
+	std::vector< std::pair<const char*, const char*> > chunks;
+	size_t size = static_cast<size_t>(end - begin);
+	if (numOfChunks < 1)
+	{
+		numOfChunks = 1;
+	}
+	if (minChunkSize > 0 && size / minChunkSize < static_cast<size_t>(numOfChunks))
+	{
+		numOfChunks = static_cast<int>(size / minChunkSize) + 1;
+	}
+	size_t chunkSize = size / numOfChunks;
+	const char* chunkBegin = begin;
+	for (int i = 1; i < numOfChunks && chunkBegin < end; i++)
+	{
+		/*! Move the nominal split point forward to the start of the next line */
+		const char* split = begin + i * chunkSize;
+		if (split <= chunkBegin)
+		{
+			continue;
+		}
+		split = skipLine(split - 1, end);
+		if (split > chunkBegin)
+		{
+			chunks.push_back(std::make_pair(chunkBegin, split));
+			chunkBegin = split;
+		}
+	}
+	if (chunkBegin < end)
+	{
+		chunks.push_back(std::make_pair(chunkBegin, end));
+	}
+	return chunks;
+}
+
+void csv::parseLinkRecords(const char* begin, const char* end, std::vector<LinkRecord>& records)
+{
+	LinkRecord record;
+	const char* p = begin;
+	while (p < end)
+	{
+		if (parseLinkRecord(p, end, record))
+		{
+			records.push_back(record);
+		}
+	}
+}
+
+void csv::parseVDSRecords(const char* begin, const char* end, std::vector<VDSRecord>& records)
+{
+	VDSRecord record;
+	const char* p = begin;
+	while (p < end)
+	{
+		if (parseVDSRecord(p, end, record))
+		{
+			records.push_back(record);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include "DataTypes.h"
+
+/*! One line of the network file: a link together with its start and end nodes */
+struct LinkRecord
+{
+	int linkID;
+	int startNodeID;
+	double startNodeLon;
+	double startNodeLat;
+	int endNodeID;
+	double endNodeLon;
+	double endNodeLat;
+};
+
+/*! One line of the VDS file */
+struct VDSRecord
+{
+	int vdsID;
+	double lat;
+	double lon;
+};
+
+/*! In-place parsers for the comma separated files of the project.
+ *  They work on a [p, end) character range (e.g. a MappedFile) and never allocate.
+ */
+namespace csv
+{
+	/*!
+	 * Returns a pointer to the first character after the end of the line that contains p.
+	 * @param p a position inside the range.
+	 * @param end the end of the range.
+	 */
+	const char* skipLine(const char* p, const char* end);
+	/*!
+	 * Parses the next comma separated field as an integer and moves p past the field.
+	 * @return false if the field is missing or is not a number.
+	 */
+	bool parseField(const char*& p, const char* lineEnd, int& value);
+	/*!
+	 * Parses the next comma separated field as a double and moves p past the field.
+	 * @return false if the field is missing or is not a number.
+	 */
+	bool parseField(const char*& p, const char* lineEnd, double& value);
+	/*!
+	 * Parses the line starting at p as a line of the network file and moves p to the next line.
+	 * @return false if the line is empty or malformed, in which case it should be skipped.
+	 */
+	bool parseLinkRecord(const char*& p, const char* end, LinkRecord& record);
+	/*!
+	 * Parses the line starting at p as a line of the VDS file and moves p to the next line.
+	 * @return false if the line is empty or malformed, in which case it should be skipped.
+	 */
+	bool parseVDSRecord(const char*& p, const char* end, VDSRecord& record);
+	/*!
+	 * Splits [begin, end) into at most numOfChunks consecutive ranges that start at the beginning of a line
+	 * and end right after a newline (or at end). Empty ranges are never returned.
+	 * @param minChunkSize ranges smaller than this are not split further, so that small files are parsed by one thread.
+	 */
+	std::vector< std::pair<const char*, const char*> > splitLines(const char* begin, const char* end, int numOfChunks, size_t minChunkSize);
+	/*!
+	 * Parses every well-formed line of [begin, end) and appends the records to the vector, in file order.
+	 */
+	void parseLinkRecords(const char* begin, const char* end, std::vector<LinkRecord>& records);
+	void parseVDSRecords(const char* begin, const char* end, std::vector<VDSRecord>& records);
+}
+
+#endif  //  CSVPARSER_H
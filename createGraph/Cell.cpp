@@ -2,43 +2,37 @@
 #include "GeoPos.h"
 #include "Link.h"
 
-Cell::Cell() : ID(-1), downLeft(nullptr), upRight(nullptr), indexX(-1), indexY(-1)
+Cell::Cell() : ID(-1), indexX(-1), indexY(-1)
 {
 }
 
-Cell::Cell(/*double ddimension,*/ int _ID) : /*dimension(ddimension),*/ ID(_ID), downLeft(nullptr), upRight(nullptr), indexX(-1), indexY(-1)
+Cell::Cell(/*double ddimension,*/ int64_t _ID) : /*dimension(ddimension),*/ ID(_ID), indexX(-1), indexY(-1)
 {
 }
 
+/*! The links of the cell belong to the Grid, so there is nothing to free here. */
 Cell::~Cell()
 {
-    if (downLeft != nullptr)
-    {
-        delete downLeft;
-    }
-    if (upRight != nullptr)
-    {
-        delete upRight;
-    }
-    if (!linksOfCell.empty())
-    {
-        linksOfCell.clear();
-    }
 }
 
-void Cell::setID(const int _ID)
+void Cell::setID(const int64_t _ID)
 {
     ID = _ID;
 }
 
-int Cell::getID() const
+int64_t Cell::getID() const
 {
     return ID;
 }
 
-std::vector<Link*>* Cell::getLinksOfCell()
+void Cell::setLinksOfCell(const LinkRange& links)
 {
-    return &linksOfCell;
+    linksOfCell = links;
+}
+
+LinkRange Cell::getLinksOfCell() const
+{
+    return linksOfCell;
 }
 
 void Cell::setIndexX(const int _indexX)
@@ -61,27 +55,22 @@ int Cell::getIndexY() const
     return indexY;
 }
 
-void Cell::setDownLeftPos(GeoPos* _downLeft)
+void Cell::setDownLeftPos(const GeoPos& _downLeft)
 {
     downLeft = _downLeft;
 }
 
 GeoPos* Cell::getDownLeftPos()
 {
-    return downLeft;
+    return &downLeft;
 }
 
-void Cell::setUpRightPos(GeoPos* _upRight)
+void Cell::setUpRightPos(const GeoPos& _upRight)
 {
     upRight = _upRight;
 }
 
 GeoPos* Cell::getUpRightPos()
 {
-    return upRight;
-}
-
-void Cell::addLink(Link* pLink)
-{
-    linksOfCell.push_back(pLink);
+    return &upRight;
 }
\ No newline at end of file
@@ -2,23 +2,25 @@
 #define CELL_H
 
 #include "DataTypes.h"
+#include "GeoPos.h"
 
-class GeoPos;
 class Link;
 
 /*! This class represents a Cell, which is a rectangle.
- *  The Cell is the structural element of the Grid. 
+ *  The Cell is the structural element of the Grid. Only the cells that hold links exist as objects;
+ *  a Cell is a view of its row of the link lists of the Grid.
  */
 class Cell
 {
     // double dimension;
-    /*! The ID of a Cell object */
-    int ID;
-    /*! A pointer to a GeoPos object representing the down left point of the cell */
-    GeoPos* downLeft;
-    /*! A pointer to a GeoPos object representing the up right point of the cell */
-    GeoPos* upRight;
-    std::vector<Link*> linksOfCell;
+    /*! The ID of a Cell object, i.e. indexY * (number of cells in x) + indexX */
+    int64_t ID;
+    /*! The down left point of the cell */
+    GeoPos downLeft;
+    /*! The up right point of the cell */
+    GeoPos upRight;
+    /*! The links of the cell, sorted by ID */
+    LinkRange linksOfCell;
     /*! The index that runs on x-axis corresponding to the index of the columns of the Grid */
     int indexX;
     /*! The index that runs on y-axis corresponding to the index of the rows of the Grid */
@@ -27,7 +29,7 @@ public:
     /*! Default constructor */
     Cell();
     /*! Constructor */
-    Cell(/*double ddimension, */int _ID);
+    Cell(/*double ddimension, */int64_t _ID);
     /*! Destructor */
     ~Cell();
     
@@ -39,19 +41,25 @@ public:
      *  @param ID the Cell object's ID
      *  @return nothing
      */
-    void setID(const int _ID);
+    void setID(const int64_t _ID);
     
     /*! Returns the ID of the Cell object
      *  @param nothing
      *  @return the ID of the Cell object
      */
-    int getID() const;
+    int64_t getID() const;
     
-    /*! Returns a pointer to the vector of pointers to Link objects of the Cell object
+    /*! Sets the links of the Cell object
+     *  @param links the row of the link lists of the Grid that belongs to the Cell object
+     *  @return nothing
+     */
+    void setLinksOfCell(const LinkRange& links);
+
+    /*! Returns the links of the Cell object
      *  @param nothing
-     *  @return a pointer to the vector of pointers to Link objects of the Cell object
+     *  @return the links of the Cell object, sorted by ID
      */
-    std::vector<Link*>* getLinksOfCell();
+    LinkRange getLinksOfCell() const;
 
     /*! Sets the indexX of the Cell object
      *  @param indexX the value of the indexX
@@ -77,11 +85,11 @@ public:
      */
     int getIndexY() const;
     
-    /*! Sets the pointer to the down left GeoPos object of the Cell object
-     *  @param downLeft a pointer to the down left GeoPos object
+    /*! Sets the down left point of the Cell object
+     *  @param downLeft the down left point
      *  @return nothing
      */
-    void setDownLeftPos(GeoPos* _downLeft);
+    void setDownLeftPos(const GeoPos& _downLeft);
     
     /*! Returns the pointer to the down left GeoPos object of the Cell object 
      *  @param nothing
@@ -89,23 +97,17 @@ public:
      */
     GeoPos* getDownLeftPos();
     
-    /*! Sets the pointer to the up right GeoPos object of the Cell object
-     *  @param upRight a pointer to the up right GeoPos object
+    /*! Sets the up right point of the Cell object
+     *  @param upRight the up right point
      *  @return nothing
      */
-    void setUpRightPos(GeoPos* _upRight);
+    void setUpRightPos(const GeoPos& _upRight);
     
     /*! Returns the pointer to the up right GeoPos object of the Cell object 
      *  @param nothing
      *  @return the pointer to the up right GeoPos object of the Cell object
      */
     GeoPos* getUpRightPos();
-    
-    /*! Adds a pointer of a Link object to the vector of pointers of Link objects of the Cell object
-     *  @param pLink pointer to a Link object
-     *  @return nothing
-     */
-    void addLink(Link* pLink);
 };
 
 #endif  //  CELL_H
\ No newline at end of file
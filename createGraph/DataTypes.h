@@ -15,26 +15,45 @@
 #include <numeric>
 #include <string>
 #include <cstdlib>
+#include <cstdint>
 #include <limits>
 #include <linux/limits.h>
 #include <cstdio>
 #include <utility>
 #include <unistd.h>
 
+#include "ElementRange.h"
+#include "ElementMap.h"
+
 class Node;
 class Link;
 class Road;
 class VDS;
 
-typedef std::map<int, Node*> NodeMap;
-typedef std::map<int, Link*> LinkMap;
-typedef std::map<int, Road*> RoadMap;
-typedef std::map<int, VDS*> VDSMap;
+/*! The elements of the network keyed by external ID, with dense indices in ascending ID order */
+typedef ElementMap<Node> NodeMap;
+typedef ElementMap<Link> LinkMap;
+typedef ElementMap<Road> RoadMap;
+typedef ElementMap<VDS> VDSMap;
+
+/*! A list of links given by their dense indices in the GraphStore */
+typedef ElementRange<Link> LinkRange;
 
 typedef std::vector<std::string> StringVector;
 
 enum Direction{oneway, bidirectional};
 
+/*! How a node connects the links through it: a dead end or a node with links only in or only out (terminal), one link in and one
+ *  link out that are not opposite (one-way pass-through), two pairs of opposite links (two-way pass-through), or anything else
+ *  (junction). Roads run through pass-through nodes, i.e. through the nodes that Node::isIntermediate() accepts. */
+enum NodeKind{terminalNode, oneWayPassThroughNode, twoWayPassThroughNode, junctionNode};
+
+/*! How the input files of the Network are read: line by line through std::ifstream, or parsed in place from a memory mapping */
+enum LoaderMode{streamLoader, mappedLoader};
+
+/*! The file formats of the adjacency matrix, see AdjacencyExporter */
+enum AdjacencyFormat{csvAdjacency, csrAdjacency, npzAdjacency, matrixMarketAdjacency};
+
 const double PI = 3.141592653589793238463;
 const double earthRadiusKm = 6371.0;
 
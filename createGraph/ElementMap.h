@@ -0,0 +1,86 @@
+#ifndef ELEMENTMAP_H
+#define ELEMENTMAP_H
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+/*! A container of network elements keyed by their external ID (the ID found in the input files).
+ *  The elements are interned once, in ascending ID order, and get the dense indices 0..N-1.
+ *  Internally the elements are addressed by dense index, which is a plain vector access;
+ *  the external ID is translated with a single hash lookup and is only needed for input/output.
+ *  Iteration visits (ID, element) pairs in ascending ID order, like a std::map<int, T*> would.
+ */
+template <typename T>
+class ElementMap
+{
+    /*! (ID, element) pairs, sorted by ID; the position of a pair is the dense index of the element */
+    std::vector< std::pair<int, T*> > entries;
+    /*! external ID -> dense index */
+    std::unordered_map<int, int> indices;
+public:
+    typedef typename std::vector< std::pair<int, T*> >::iterator iterator;
+    typedef typename std::vector< std::pair<int, T*> >::const_iterator const_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void reserve(size_t size)
+    {
+        entries.reserve(size);
+        indices.reserve(size);
+    }
+
+    void clear()
+    {
+        entries.clear();
+        indices.clear();
+    }
+
+    /*! Interns an element. IDs must be given in strictly ascending order, so that dense indices follow ID order.
+     *  @return the dense index of the element, or -1 if the ID is not larger than the last one (the element is not added)
+     */
+    int insert(const int ID, T* element)
+    {
+        if (!entries.empty() && ID <= entries.back().first)
+        {
+            return -1;
+        }
+        int index = static_cast<int>(entries.size());
+        entries.push_back(std::make_pair(ID, element));
+        indices.insert(std::make_pair(ID, index));
+        return index;
+    }
+
+    /*! Returns the dense index of the element with the given ID, or -1 if there is none */
+    int indexOf(const int ID) const
+    {
+        auto it = indices.find(ID);
+        return (it != indices.end()) ? it->second : -1;
+    }
+
+    /*! Returns the element with the given ID, or nullptr if there is none */
+    T* get(const int ID) const
+    {
+        auto it = indices.find(ID);
+        return (it != indices.end()) ? entries[it->second].second : nullptr;
+    }
+
+    /*! Returns an iterator to the (ID, element) pair with the given ID, or end() if there is none */
+    iterator find(const int ID)
+    {
+        int index = indexOf(ID);
+        return (index != -1) ? entries.begin() + index : entries.end();
+    }
+
+    /*! Returns the element with the given dense index */
+    T* at(const int index) const { return entries[index].second; }
+    /*! Returns the external ID of the element with the given dense index */
+    int getID(const int index) const { return entries[index].first; }
+};
+
+#endif  //  ELEMENTMAP_H
@@ -0,0 +1,47 @@
+#ifndef ELEMENTRANGE_H
+#define ELEMENTRANGE_H
+
+#include <cstddef>
+
+/*! An iterable view over a list of network elements stored as dense indices (e.g. one row of a CSR array).
+ *  Iterating it yields pointers into the contiguous array of elements the indices refer to,
+ *  in the order of the underlying list.
+ */
+template <typename T>
+class ElementRange
+{
+    const int* first;
+    const int* last;
+    T* elements;
+public:
+    class iterator
+    {
+        const int* p;
+        T* elements;
+    public:
+        iterator(const int* _p, T* _elements) : p(_p), elements(_elements) {}
+        T* operator*() const { return elements + *p; }
+        iterator& operator++() { ++p; return *this; }
+        bool operator==(const iterator& it) const { return p == it.p; }
+        bool operator!=(const iterator& it) const { return p != it.p; }
+    };
+
+    /*! Default constructor, an empty range */
+    ElementRange() : first(nullptr), last(nullptr), elements(nullptr) {}
+    /*! Constructor
+     *  @param _first the first index of the list
+     *  @param _last one past the last index of the list
+     *  @param _elements the elements the indices refer to
+     */
+    ElementRange(const int* _first, const int* _last, T* _elements) : first(_first), last(_last), elements(_elements) {}
+
+    iterator begin() const { return iterator(first, elements); }
+    iterator end() const { return iterator(last, elements); }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    T* operator[](size_t i) const { return elements + first[i]; }
+    /*! Returns the dense index of the i-th element */
+    int indexAt(size_t i) const { return first[i]; }
+};
+
+#endif  //  ELEMENTRANGE_H
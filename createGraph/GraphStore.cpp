@@ -0,0 +1,554 @@
+#include <omp.h>
+
+#include "GraphStore.h"
+#include "Node.h"
+#include "Link.h"
+#include "CSVParser.h"
+#include "MathFunc.h"
+
+#include <unordered_map>
+
+GraphStore::GraphStore()
+{
+}
+
+GraphStore::~GraphStore()
+{
+}
+
+void GraphStore::build(const std::vector<LinkRecord>& records, int numThreads)
+{
+    clear();
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+
+    /*! Every line contributes its start node and then its end node; a node keeps the position of its first appearance */
+    struct NodeAppearance
+    {
+        int ID;
+        double lat;
+        double lon;
+    };
+    std::vector<NodeAppearance> appearances;
+    appearances.reserve(2 * records.size());
+    for (const auto& record : records)
+    {
+        appearances.push_back(NodeAppearance{record.startNodeID, record.startNodeLat, record.startNodeLon});
+        appearances.push_back(NodeAppearance{record.endNodeID, record.endNodeLat, record.endNodeLon});
+    }
+    std::stable_sort(appearances.begin(), appearances.end(), [](const NodeAppearance& a, const NodeAppearance& b) { return a.ID < b.ID; });
+
+    /*! The lines of the links, in ID order; a link ID that appears more than once keeps its first line */
+    std::vector<int> order(records.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&records](int a, int b) { return records[a].linkID < records[b].linkID; });
+    order.erase(std::unique(order.begin(), order.end(), [&records](int a, int b) { return records[a].linkID == records[b].linkID; }), order.end());
+
+    size_t numOfNodes = 0;
+    for (size_t i = 0; i < appearances.size(); i++)
+    {
+        if (i == 0 || appearances[i].ID != appearances[i - 1].ID)
+        {
+            numOfNodes++;
+        }
+    }
+    reserve(numOfNodes, order.size());
+    for (size_t i = 0; i < appearances.size(); i++)
+    {
+        if (i == 0 || appearances[i].ID != appearances[i - 1].ID)
+        {
+            addNode(appearances[i].ID, appearances[i].lat, appearances[i].lon);
+        }
+    }
+
+    /*! nodeIDs is sorted, so the dense index of a node is found by binary search */
+    int numOfLinks = static_cast<int>(order.size());
+    linkIDs.resize(numOfLinks);
+    linkStartNodes.resize(numOfLinks);
+    linkEndNodes.resize(numOfLinks);
+    linkLengths.assign(numOfLinks, 0.0);
+    linkDirections.assign(numOfLinks, oneway);
+    oppositeLinks.assign(numOfLinks, -1);
+    linkRoads.assign(numOfLinks, nullptr);
+#pragma omp parallel for num_threads(numThreads)
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        const LinkRecord& record = records[order[i]];
+        linkIDs[i] = record.linkID;
+        linkStartNodes[i] = static_cast<int>(std::lower_bound(nodeIDs.begin(), nodeIDs.end(), record.startNodeID) - nodeIDs.begin());
+        linkEndNodes[i] = static_cast<int>(std::lower_bound(nodeIDs.begin(), nodeIDs.end(), record.endNodeID) - nodeIDs.begin());
+    }
+    computeLinkLengths(numThreads);
+    finalize();
+}
+
+void GraphStore::reserve(size_t numOfNodes, size_t numOfLinks)
+{
+    nodeIDs.reserve(numOfNodes);
+    nodeLats.reserve(numOfNodes);
+    nodeLons.reserve(numOfNodes);
+    linkIDs.reserve(numOfLinks);
+    linkStartNodes.reserve(numOfLinks);
+    linkEndNodes.reserve(numOfLinks);
+    linkLengths.reserve(numOfLinks);
+    linkDirections.reserve(numOfLinks);
+    oppositeLinks.reserve(numOfLinks);
+    linkRoads.reserve(numOfLinks);
+}
+
+int GraphStore::addNode(const int ID, const double lat, const double lon)
+{
+    nodeIDs.push_back(ID);
+    nodeLats.push_back(lat);
+    nodeLons.push_back(lon);
+    return static_cast<int>(nodeIDs.size()) - 1;
+}
+
+int GraphStore::addLink(const int ID, const int startNode, const int endNode, const double length)
+{
+    linkIDs.push_back(ID);
+    linkStartNodes.push_back(startNode);
+    linkEndNodes.push_back(endNode);
+    linkLengths.push_back(length);
+    linkDirections.push_back(oneway);
+    oppositeLinks.push_back(-1);
+    linkRoads.push_back(nullptr);
+    return static_cast<int>(linkIDs.size()) - 1;
+}
+
+void GraphStore::finalize()
+{
+    createIncidence();
+    createViews();
+}
+
+void GraphStore::createIncidence()
+{
+    /*! Counting sort of the links by node. The links are visited in index order, so every row ends up sorted by link index. */
+    size_t numOfNodes = nodeIDs.size();
+    size_t numOfLinks = linkIDs.size();
+    outgoingOffsets.assign(numOfNodes + 1, 0);
+    incomingOffsets.assign(numOfNodes + 1, 0);
+    for (size_t i = 0; i < numOfLinks; i++)
+    {
+        outgoingOffsets[linkStartNodes[i] + 1]++;
+        incomingOffsets[linkEndNodes[i] + 1]++;
+    }
+    for (size_t n = 0; n < numOfNodes; n++)
+    {
+        outgoingOffsets[n + 1] += outgoingOffsets[n];
+        incomingOffsets[n + 1] += incomingOffsets[n];
+    }
+    outgoingLinks.resize(numOfLinks);
+    incomingLinks.resize(numOfLinks);
+    std::vector<int> outgoingNext(outgoingOffsets.begin(), outgoingOffsets.end() - 1);
+    std::vector<int> incomingNext(incomingOffsets.begin(), incomingOffsets.end() - 1);
+    for (size_t i = 0; i < numOfLinks; i++)
+    {
+        outgoingLinks[outgoingNext[linkStartNodes[i]]++] = static_cast<int>(i);
+        incomingLinks[incomingNext[linkEndNodes[i]]++] = static_cast<int>(i);
+    }
+}
+
+void GraphStore::createViews()
+{
+    nodes.clear();
+    links.clear();
+    nodes.reserve(nodeIDs.size());
+    links.reserve(linkIDs.size());
+    for (size_t n = 0; n < nodeIDs.size(); n++)
+    {
+        nodes.push_back(Node(this, static_cast<int>(n)));
+    }
+    for (size_t i = 0; i < linkIDs.size(); i++)
+    {
+        links.push_back(Link(this, static_cast<int>(i)));
+    }
+}
+
+void GraphStore::createNeighbourhoods(int numThreads)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    int numOfLinks = static_cast<int>(linkIDs.size());
+    const int numOfRows = numOfNeighbourLists * numOfLinks;
+    neighbourOffsets.assign(numOfRows + 1, 0);
+
+    /*! The before links of a link are the links of its start node and the after links those of its end node,
+     *  in and out as in the incidence of the node, except for the link itself. */
+    auto nodeRow = [this](int link, int list, const int*& first, const int*& last)
+    {
+        int node = (list < 2) ? linkStartNodes[link] : linkEndNodes[link];
+        const std::vector<int>& offsets = (list % 2 == 0) ? incomingOffsets : outgoingOffsets;
+        const std::vector<int>& incident = (list % 2 == 0) ? incomingLinks : outgoingLinks;
+        first = incident.data() + offsets[node];
+        last = incident.data() + offsets[node + 1];
+    };
+
+#pragma omp parallel num_threads(numThreads)
+    {
+#pragma omp for
+        for (int i = 0; i < numOfLinks; i++)
+        {
+            for (int list = 0; list < numOfNeighbourLists; list++)
+            {
+                const int* first;
+                const int* last;
+                nodeRow(i, list, first, last);
+                int count = static_cast<int>(last - first);
+                if (std::binary_search(first, last, i))
+                {
+                    count--;
+                }
+                neighbourOffsets[numOfNeighbourLists * i + list + 1] = count;
+            }
+        }
+#pragma omp single
+        {
+            for (int row = 0; row < numOfRows; row++)
+            {
+                neighbourOffsets[row + 1] += neighbourOffsets[row];
+            }
+            neighbourLinks.resize(neighbourOffsets[numOfRows]);
+        }
+#pragma omp for
+        for (int i = 0; i < numOfLinks; i++)
+        {
+            for (int list = 0; list < numOfNeighbourLists; list++)
+            {
+                const int* first;
+                const int* last;
+                nodeRow(i, list, first, last);
+                int* out = neighbourLinks.data() + neighbourOffsets[numOfNeighbourLists * i + list];
+                for (const int* p = first; p != last; ++p)
+                {
+                    if (*p != i)
+                    {
+                        *out++ = *p;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void GraphStore::setNeighbourhoods(std::vector<int>&& offsets, std::vector<int>&& neighbours)
+{
+    neighbourOffsets = std::move(offsets);
+    neighbourLinks = std::move(neighbours);
+}
+
+size_t GraphStore::pairOppositeLinks()
+{
+    int numOfLinks = static_cast<int>(linkIDs.size());
+    oppositeLinks.assign(numOfLinks, -1);
+    linkDirections.assign(numOfLinks, oneway);
+    nodeKinds.clear();
+    departureLinks.clear();
+
+    // The links still waiting for an opposite, per (start node, end node): a queue in link order, threaded through nextWaiting
+    auto key = [](int startNode, int endNode) { return (static_cast<uint64_t>(static_cast<uint32_t>(startNode)) << 32) | static_cast<uint32_t>(endNode); };
+    std::unordered_map< uint64_t, std::pair<int, int> > waiting;
+    waiting.reserve(numOfLinks);
+    std::vector<int> nextWaiting(numOfLinks, -1);
+    size_t numOfPairs = 0;
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        int startNode = linkStartNodes[i];
+        int endNode = linkEndNodes[i];
+        if (startNode == endNode)
+        {
+            continue;
+        }
+        auto opposite = waiting.find(key(endNode, startNode));
+        if (opposite != waiting.end())
+        {
+            int j = opposite->second.first;
+            oppositeLinks[i] = j;
+            oppositeLinks[j] = i;
+            linkDirections[i] = bidirectional;
+            linkDirections[j] = bidirectional;
+            numOfPairs++;
+            if (nextWaiting[j] == -1)
+            {
+                waiting.erase(opposite);
+            }
+            else
+            {
+                opposite->second.first = nextWaiting[j];
+            }
+            continue;
+        }
+        auto queue = waiting.find(key(startNode, endNode));
+        if (queue == waiting.end())
+        {
+            waiting.emplace(key(startNode, endNode), std::make_pair(i, i));
+        }
+        else
+        {
+            nextWaiting[queue->second.second] = i;
+            queue->second.second = i;
+        }
+    }
+    return numOfPairs;
+}
+
+void GraphStore::classifyNodes(int numThreads)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    int numOfNodes = static_cast<int>(nodeIDs.size());
+    nodeKinds.assign(numOfNodes, junctionNode);
+    departureLinks.assign(linkIDs.size(), -1);
+    // The tests are those of Node::isIntermediate() and Node::isIntermediateGetDepar(); a link is opposite of another if its opposite link is that one
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 4096)
+    for (int n = 0; n < numOfNodes; n++)
+    {
+        const int* outgoing = outgoingLinks.data() + outgoingOffsets[n];
+        const int* incoming = incomingLinks.data() + incomingOffsets[n];
+        int numOfOutgoing = outgoingOffsets[n + 1] - outgoingOffsets[n];
+        int numOfIncoming = incomingOffsets[n + 1] - incomingOffsets[n];
+        NodeKind kind = junctionNode;
+        if (numOfOutgoing == 0 || numOfIncoming == 0)
+        {
+            kind = terminalNode;
+        }
+        else if (numOfOutgoing == 1 && numOfIncoming == 1)
+        {
+            if (oppositeLinks[outgoing[0]] == incoming[0])
+            {
+                kind = terminalNode;
+            }
+            else
+            {
+                kind = oneWayPassThroughNode;
+                departureLinks[incoming[0]] = outgoing[0];
+            }
+        }
+        else if (numOfOutgoing == 2 && numOfIncoming == 2)
+        {
+            if ((oppositeLinks[outgoing[1]] == incoming[1] && oppositeLinks[outgoing[0]] == incoming[0])
+                || (oppositeLinks[outgoing[1]] == incoming[0] && oppositeLinks[outgoing[0]] == incoming[1]))
+            {
+                kind = twoWayPassThroughNode;
+                // The second outgoing link is tried first, as in Node::isIntermediateGetDepar()
+                for (int k = 0; k < 2; k++)
+                {
+                    if (oppositeLinks[outgoing[1]] != incoming[k])
+                    {
+                        departureLinks[incoming[k]] = outgoing[1];
+                    }
+                    else if (oppositeLinks[outgoing[0]] != incoming[k])
+                    {
+                        departureLinks[incoming[k]] = outgoing[0];
+                    }
+                }
+            }
+        }
+        nodeKinds[n] = static_cast<uint8_t>(kind);
+    }
+}
+
+bool GraphStore::isClassified() const
+{
+    return !nodeIDs.empty() && nodeKinds.size() == nodeIDs.size();
+}
+
+void GraphStore::computeLinkLengths(int numThreads)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    int numOfLinks = static_cast<int>(linkIDs.size());
+    linkLengths.resize(numOfLinks);
+#pragma omp parallel for num_threads(numThreads)
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        int startNode = linkStartNodes[i];
+        int endNode = linkEndNodes[i];
+        linkLengths[i] = mfnc::calcPointsDistance(nodeLons[startNode], nodeLats[startNode], nodeLons[endNode], nodeLats[endNode]);
+    }
+}
+
+void GraphStore::clear()
+{
+    nodes.clear();
+    links.clear();
+    nodeIDs.clear();
+    nodeLats.clear();
+    nodeLons.clear();
+    outgoingOffsets.clear();
+    outgoingLinks.clear();
+    incomingOffsets.clear();
+    incomingLinks.clear();
+    neighbourOffsets.clear();
+    neighbourLinks.clear();
+    linkIDs.clear();
+    linkStartNodes.clear();
+    linkEndNodes.clear();
+    linkLengths.clear();
+    linkDirections.clear();
+    oppositeLinks.clear();
+    linkRoads.clear();
+    nodeKinds.clear();
+    departureLinks.clear();
+}
+
+size_t GraphStore::getNumOfNodes() const
+{
+    return nodeIDs.size();
+}
+
+size_t GraphStore::getNumOfLinks() const
+{
+    return linkIDs.size();
+}
+
+Node* GraphStore::getNode(const int node)
+{
+    return &nodes[node];
+}
+
+Link* GraphStore::getLink(const int link)
+{
+    return &links[link];
+}
+
+int GraphStore::getNodeID(const int node) const
+{
+    return nodeIDs[node];
+}
+
+double GraphStore::getNodeLat(const int node) const
+{
+    return nodeLats[node];
+}
+
+double GraphStore::getNodeLon(const int node) const
+{
+    return nodeLons[node];
+}
+
+void GraphStore::setNodePos(const int node, const double lat, const double lon)
+{
+    nodeLats[node] = lat;
+    nodeLons[node] = lon;
+}
+
+const double* GraphStore::getNodeLats() const
+{
+    return nodeLats.data();
+}
+
+const double* GraphStore::getNodeLons() const
+{
+    return nodeLons.data();
+}
+
+LinkRange GraphStore::getOutgoingLinks(const int node)
+{
+    const int* first = outgoingLinks.data();
+    return LinkRange(first + outgoingOffsets[node], first + outgoingOffsets[node + 1], links.data());
+}
+
+LinkRange GraphStore::getIncomingLinks(const int node)
+{
+    const int* first = incomingLinks.data();
+    return LinkRange(first + incomingOffsets[node], first + incomingOffsets[node + 1], links.data());
+}
+
+NodeKind GraphStore::getNodeKind(const int node) const
+{
+    return static_cast<NodeKind>(nodeKinds[node]);
+}
+
+int GraphStore::getLinkID(const int link) const
+{
+    return linkIDs[link];
+}
+
+int GraphStore::getLinkStartNode(const int link) const
+{
+    return linkStartNodes[link];
+}
+
+int GraphStore::getLinkEndNode(const int link) const
+{
+    return linkEndNodes[link];
+}
+
+const int* GraphStore::getLinkStartNodes() const
+{
+    return linkStartNodes.data();
+}
+
+const int* GraphStore::getLinkEndNodes() const
+{
+    return linkEndNodes.data();
+}
+
+double GraphStore::getLinkLength(const int link) const
+{
+    return linkLengths[link];
+}
+
+void GraphStore::setLinkLength(const int link, const double length)
+{
+    linkLengths[link] = length;
+}
+
+Direction GraphStore::getLinkDirection(const int link) const
+{
+    return linkDirections[link];
+}
+
+void GraphStore::setLinkDirection(const int link, const Direction direction)
+{
+    linkDirections[link] = direction;
+}
+
+int GraphStore::getOppositeLink(const int link) const
+{
+    return oppositeLinks[link];
+}
+
+void GraphStore::setOppositeLink(const int link, const int oppositeLink)
+{
+    oppositeLinks[link] = oppositeLink;
+    nodeKinds.clear();
+    departureLinks.clear();
+}
+
+int GraphStore::getDepartureLink(const int link) const
+{
+    return departureLinks[link];
+}
+
+LinkRange GraphStore::getNeighbourLinks(const int link, const int list)
+{
+    if (neighbourOffsets.empty())
+    {
+        /*! createNeighbourhoods() has not run yet */
+        return LinkRange();
+    }
+    int row = numOfNeighbourLists * link + list;
+    const int* first = neighbourLinks.data();
+    return LinkRange(first + neighbourOffsets[row], first + neighbourOffsets[row + 1], links.data());
+}
+
+Road* GraphStore::getLinkRoad(const int link) const
+{
+    return linkRoads[link];
+}
+
+void GraphStore::setLinkRoad(const int link, Road* road)
+{
+    linkRoads[link] = road;
+}
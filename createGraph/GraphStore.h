@@ -0,0 +1,145 @@
+#ifndef GRAPHSTORE_H
+#define GRAPHSTORE_H
+
+#include "DataTypes.h"
+
+class Node;
+class Link;
+class Road;
+struct LinkRecord;
+
+/*! This class holds the topology of the network in contiguous structure-of-arrays form.
+ *  Nodes and links are identified by dense indices 0..N-1, assigned in ascending order of their external IDs,
+ *  so iterating by index visits them in the same order as a std::map keyed by ID would.
+ *  The Node and Link objects are thin views (store pointer + index) that are owned by the store
+ *  and live in two contiguous vectors; they stay valid until the store is destroyed.
+ */
+class GraphStore
+{
+    /*! nodes */
+    std::vector<int> nodeIDs;
+    std::vector<double> nodeLats;
+    std::vector<double> nodeLons;
+    /*! node incidence in compressed sparse row form: the outgoing links of node n are
+     *  outgoingLinks[outgoingOffsets[n] .. outgoingOffsets[n + 1]), sorted by link index; the same for incoming links */
+    std::vector<int> outgoingOffsets;
+    std::vector<int> outgoingLinks;
+    std::vector<int> incomingOffsets;
+    std::vector<int> incomingLinks;
+    /*! before/after neighbourhoods of the links in compressed sparse row form, four consecutive rows per link:
+     *  row 4 * i + k holds the before-in (k = 0), before-out (k = 1), after-in (k = 2) and after-out (k = 3) links of link i,
+     *  i.e. neighbourLinks[neighbourOffsets[4 * i + k] .. neighbourOffsets[4 * i + k + 1]), sorted by link index */
+    std::vector<int> neighbourOffsets;
+    std::vector<int> neighbourLinks;
+    /*! links */
+    std::vector<int> linkIDs;
+    std::vector<int> linkStartNodes;
+    std::vector<int> linkEndNodes;
+    std::vector<double> linkLengths;
+    std::vector<Direction> linkDirections;
+    /*! index of the opposite link, -1 if there is none */
+    std::vector<int> oppositeLinks;
+    std::vector<Road*> linkRoads;
+    /*! The classification of the nodes: the kind of every node, and for every link the link to depart on after arriving
+     *  at its end node, -1 if the end node is not a pass-through; both empty until classifyNodes() */
+    std::vector<uint8_t> nodeKinds;
+    std::vector<int> departureLinks;
+    /*! views */
+    std::vector<Node> nodes;
+    std::vector<Link> links;
+
+    void createIncidence();
+    void createViews();
+public:
+    /*! Default constructor */
+    GraphStore();
+    /*! Destructor */
+    ~GraphStore();
+    /*! The views point back to the store, hence it can be neither copied nor moved */
+    GraphStore(const GraphStore& store) = delete;
+    GraphStore& operator=(const GraphStore& store) = delete;
+
+    /*! Builds the store from the lines of a network file, given in file order.
+     *  A node takes the coordinates of its first appearance and, if a link ID appears more than once, its first line is kept.
+     *  @param records the lines of the network file
+     *  @param numThreads the number of OpenMP threads, 0 means the OpenMP default
+     */
+    void build(const std::vector<LinkRecord>& records, int numThreads);
+
+    /*! Routines for filling the store element by element (e.g. from a snapshot).
+     *  Nodes and links must be added in ascending ID order, and finalize() must be called once at the end.
+     */
+    void reserve(size_t numOfNodes, size_t numOfLinks);
+    int addNode(const int ID, const double lat, const double lon);
+    int addLink(const int ID, const int startNode, const int endNode, const double length);
+    void finalize();
+
+    /*! Derives the before/after neighbourhoods of every link from the incidence of its start and end node.
+     *  The rows are counted and then filled in parallel over the links, with a prefix sum in between.
+     */
+    void createNeighbourhoods(int numThreads);
+    /*! Sets the neighbourhoods directly (e.g. from a snapshot); the arrays must have the layout of neighbourOffsets/neighbourLinks */
+    void setNeighbourhoods(std::vector<int>&& offsets, std::vector<int>&& neighbours);
+
+    /*! Pairs every link with the link in the opposite direction between the same nodes, through a hash map of
+     *  (start node, end node) in a single pass over the links, and sets the direction of every link: bidirectional
+     *  if it has been paired, oneway otherwise. If several links join the same nodes in the same direction, the k-th
+     *  of them in ID order is paired with the k-th in the opposite direction; a link from a node to itself is never paired.
+     *  @return the number of pairs
+     */
+    size_t pairOppositeLinks();
+
+    /*! Classifies every node by its incidence and the opposite links, in parallel over the nodes, so that
+     *  Node::isIntermediate() and Node::isIntermediateGetDepar() become lookups. setOppositeLink() drops the
+     *  classification, so it must be repeated after the opposite links change.
+     */
+    void classifyNodes(int numThreads);
+    bool isClassified() const;
+
+    /*! Computes the length of every link from the coordinates of its nodes */
+    void computeLinkLengths(int numThreads);
+    /*! Removes all nodes and links */
+    void clear();
+
+    /*! Setters - Getters */
+    size_t getNumOfNodes() const;
+    size_t getNumOfLinks() const;
+    Node* getNode(const int node);
+    Link* getLink(const int link);
+    /*! The number of neighbour lists of a link */
+    static const int numOfNeighbourLists = 4;
+
+    int getNodeID(const int node) const;
+    double getNodeLat(const int node) const;
+    double getNodeLon(const int node) const;
+    void setNodePos(const int node, const double lat, const double lon);
+    const double* getNodeLats() const;
+    const double* getNodeLons() const;
+    LinkRange getOutgoingLinks(const int node);
+    LinkRange getIncomingLinks(const int node);
+    /*! The kind of a node, after classifyNodes() */
+    NodeKind getNodeKind(const int node) const;
+
+    int getLinkID(const int link) const;
+    int getLinkStartNode(const int link) const;
+    int getLinkEndNode(const int link) const;
+    const int* getLinkStartNodes() const;
+    const int* getLinkEndNodes() const;
+    double getLinkLength(const int link) const;
+    void setLinkLength(const int link, const double length);
+    Direction getLinkDirection(const int link) const;
+    void setLinkDirection(const int link, const Direction direction);
+    int getOppositeLink(const int link) const;
+    void setOppositeLink(const int link, const int oppositeLink);
+    /*! The link to depart on after arriving on a link at its end node, as Node::isIntermediateGetDepar() finds it,
+     *  -1 if the road ends there; after classifyNodes() */
+    int getDepartureLink(const int link) const;
+    /*! Returns one of the four neighbour lists of a link
+     *  @param list 0 for before-in, 1 for before-out, 2 for after-in and 3 for after-out links
+     */
+    LinkRange getNeighbourLinks(const int link, const int list);
+    Road* getLinkRoad(const int link) const;
+    void setLinkRoad(const int link, Road* road);
+};
+
+#endif  //  GRAPHSTORE_H
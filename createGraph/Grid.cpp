@@ -1,3 +1,5 @@
+#include <omp.h>
+
 #include "Grid.h"
 #include "Cell.h"
 #include "GeoPos.h"
@@ -5,30 +7,74 @@
 #include "Node.h"
 #include "Link.h"
 #include "Network.h"
+#include "GraphStore.h"
+#include "Profiler.h"
 
-Grid::Grid(double _dimension, Network* _network) : dimension(_dimension), network(_network), minLat(-1), maxLat(-1), minLon(-1), maxLon(-1), numOfCellsInX(-1), numOfCellsInY(-1)
-{
-}
-
-Grid::~Grid()
+namespace
 {
-    if (!cells.empty())
+    /*! Visits the cells crossed by a segment with a supercover traversal (Amanatides-Woo): from the cell of the
+     *  start point it steps into the neighbouring cell whose boundary the segment crosses first, and when the
+     *  segment crosses a corner exactly, both cells beside the corner are visited as well. A segment spanning
+     *  w x h cells costs O(w + h) and every cell is visited once.
+     *  The points are given in cell units relative to the down left corner of the grid, i.e. cell (i, j) is
+     *  [i, i + 1) x [j, j + 1); cells beyond the last column or row are clamped into it.
+     *  @param visit called with the indices (x, y) of every cell
+     */
+    template <typename Visit>
+    void traverseCells(double startX, double startY, double endX, double endY, int numOfCellsInX, int numOfCellsInY, Visit visit)
     {
-        for (const auto& v : cells)
+        int x = std::min(static_cast<int>(startX), numOfCellsInX - 1);
+        int y = std::min(static_cast<int>(startY), numOfCellsInY - 1);
+        int eX = std::min(static_cast<int>(endX), numOfCellsInX - 1);
+        int eY = std::min(static_cast<int>(endY), numOfCellsInY - 1);
+        visit(x, y);
+        double dX = endX - startX;
+        double dY = endY - startY;
+        int stepX = (eX > x) ? 1 : -1;
+        int stepY = (eY > y) ? 1 : -1;
+        double tDeltaX = (dX != 0.0) ? std::fabs(1.0 / dX) : std::numeric_limits<double>::infinity();
+        double tDeltaY = (dY != 0.0) ? std::fabs(1.0 / dY) : std::numeric_limits<double>::infinity();
+        double tMaxX = (dX != 0.0) ? ((stepX > 0) ? (x + 1 - startX) : (startX - x)) * tDeltaX : std::numeric_limits<double>::infinity();
+        double tMaxY = (dY != 0.0) ? ((stepY > 0) ? (y + 1 - startY) : (startY - y)) * tDeltaY : std::numeric_limits<double>::infinity();
+        while (x != eX || y != eY)
         {
-            for (const auto& cell : v)
+            // Never step past the column or the row of the end cell, whatever the rounding of tMax
+            if (y == eY || (x != eX && tMaxX < tMaxY))
+            {
+                x += stepX;
+                tMaxX += tDeltaX;
+            }
+            else if (x == eX || tMaxY < tMaxX)
+            {
+                y += stepY;
+                tMaxY += tDeltaY;
+            }
+            else
             {
-                if (cell != nullptr)
-                {
-                    delete cell;
-                }
+                visit(x + stepX, y);
+                visit(x, y + stepY);
+                x += stepX;
+                y += stepY;
+                tMaxX += tDeltaX;
+                tMaxY += tDeltaY;
             }
+            visit(x, y);
         }
     }
 }
 
+Grid::Grid(double _dimension, Network* _network) : dimension(_dimension), network(_network), minLat(-1), maxLat(-1), minLon(-1), maxLon(-1), numOfCellsInX(-1), numOfCellsInY(-1)
+{
+}
+
+/*! The cells are values and their links belong to the link lists, so there is nothing to free here. */
+Grid::~Grid()
+{
+}
+
 void Grid::build()
 {
+    PROFILE_PHASE(phase, "Grid::build");
     // Find the (lon, lat) = (x,y) limits of the network 
     NodeMap* nodeMap = network->getNodes();
     NodeMap::iterator it = nodeMap->begin();
@@ -72,145 +118,165 @@ void Grid::build()
     double numOfCellsInY_d = diffy / dimension;
     numOfCellsInY = ceil(numOfCellsInY_d);
     // std::cout << "Num cells in Y: " << numOfCellsInY << "\n";
-    std::cout << "Total number of cells in the grid: " << numOfCellsInX * numOfCellsInY << "\n";
+    std::cout << "Total number of cells in the grid: " << getNumOfCells() << "\n";
 
-    // Create Cell objects
-    int cellID = 0;
-    for (int i = 0; i < numOfCellsInY; i++)
+    // The cells are created by assignLinksToGrid(), only where there are links
+    cellIDs.clear();
+    cells.clear();
+    cellOffsets.assign(1, 0);
+    cellLinks.clear();
+    PROFILE_COUNT(phase, "cells", static_cast<size_t>(getNumOfCells()));
+}
+
+void Grid::assignLinksToGrid(int numThreads)
+{
+    PROFILE_PHASE(phase, "Grid::assignLinksToGrid");
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    GraphStore* store = network->getGraphStore();
+    const double* nodeLons = store->getNodeLons();
+    const double* nodeLats = store->getNodeLats();
+    const int* linkStartNodes = store->getLinkStartNodes();
+    const int* linkEndNodes = store->getLinkEndNodes();
+    int numOfLinks = static_cast<int>(store->getNumOfLinks());
+
+    // (cell ID, link) pairs of every thread, turned into the link lists of the cells at the end
+    std::vector< std::vector< std::pair<int64_t, int> > > buffers(numThreads);
+#pragma omp parallel num_threads(numThreads)
     {
-        std::vector<Cell*> cells_temp;
-        for (int j = 0; j < numOfCellsInX; j++)
+        std::vector< std::pair<int64_t, int> >& assignments = buffers[omp_get_thread_num()];
+        auto addLink = [this, &assignments](int indexX, int indexY, int link)
         {
-            cellID = i * numOfCellsInX + j;
-            Cell* cell = new Cell(/*dimension,*/ cellID);
-            cell->setIndexX(j);
-            cell->setIndexY(i);
-            double lat = minLat + i * dimension;
-            double lon = minLon + j * dimension;
-            GeoPos* pos = new GeoPos(lat, lon);
-            cell->setDownLeftPos(pos);
-            pos = new GeoPos(lat + dimension, lon + dimension);
-            cell->setUpRightPos(pos);
-            cells_temp.push_back(cell);
+            assignments.push_back(std::make_pair(static_cast<int64_t>(indexY) * numOfCellsInX + indexX, link));
+        };
+#pragma omp for schedule(dynamic, 1024)
+        for (int link = 0; link < numOfLinks; link++)
+        {
+            double startLon = nodeLons[linkStartNodes[link]];
+            double startLat = nodeLats[linkStartNodes[link]];
+            double endLon = nodeLons[linkEndNodes[link]];
+            double endLat = nodeLats[linkEndNodes[link]];
+            int x, y;
+            if (!getCellIndices(startLat, startLon, x, y) || !getCellIndices(endLat, endLon, x, y))
+            {
+                continue;
+            }
+            traverseCells((startLon - minLon) / dimension, (startLat - minLat) / dimension, (endLon - minLon) / dimension, (endLat - minLat) / dimension,
+                numOfCellsInX, numOfCellsInY, [&addLink, link](int indexX, int indexY) { addLink(indexX, indexY, link); });
         }
-        cells.push_back(cells_temp);
-        cells_temp.clear();
     }
+
+    std::vector< std::pair<int64_t, int> > assignments;
+    size_t numOfAssignments = 0;
+    for (const auto& buffer : buffers)
+    {
+        numOfAssignments += buffer.size();
+    }
+    assignments.reserve(numOfAssignments);
+    for (const auto& buffer : buffers)
+    {
+        assignments.insert(assignments.end(), buffer.begin(), buffer.end());
+    }
+    createCells(assignments);
+    PROFILE_COUNT(phase, "links", static_cast<size_t>(numOfLinks));
+    PROFILE_COUNT(phase, "assignments", cellLinks.size());
+    PROFILE_COUNT(phase, "occupiedCells", cells.size());
 }
 
-void Grid::assignLinksToGrid()
+void Grid::createCells(std::vector< std::pair<int64_t, int> >& assignments)
 {
-    auto linkMap = network->getLinks();
-    for (auto it = linkMap->begin(); it != linkMap->end(); ++it)
+    // Sorting by cell and then by link gives every cell its links in ID order, each of them once
+    std::sort(assignments.begin(), assignments.end());
+    assignments.erase(std::unique(assignments.begin(), assignments.end()), assignments.end());
+
+    cellIDs.clear();
+    cells.clear();
+    cellOffsets.assign(1, 0);
+    cellLinks.resize(assignments.size());
+    for (size_t a = 0; a < assignments.size(); a++)
     {
-        Link* pLink = it->second;
-        Node* startNode = pLink->getStartNode();
-        Node* endNode = pLink->getEndNode();
-        Cell* sCell = getCellContainingNode(startNode);
-        Cell* eCell = getCellContainingNode(endNode);
-        if (sCell->getID() == eCell->getID())
+        if (a == 0 || assignments[a].first != assignments[a - 1].first)
         {
-            // The link starts and ends within the same cell
-            sCell->addLink(pLink);
-        }
-        else
-        {
-            sCell->addLink(pLink);
-            eCell->addLink(pLink);
-            int minX = std::min(sCell->getIndexX(), eCell->getIndexX());
-            int minY = std::min(sCell->getIndexY(), eCell->getIndexY());
-            int maxX = std::max(sCell->getIndexX(), eCell->getIndexX());
-            int maxY = std::max(sCell->getIndexY(), eCell->getIndexY());
-
-            if (sCell->getIndexX() == eCell->getIndexX())
-            {
-                // The link starts and ends in cells of equal longitude (X)
-                for (int i = minY; i <= maxY; i++)
-                    cells[i][minX]->addLink(pLink);
-            }
-            else
+            if (a > 0)
             {
-                if (sCell->getIndexY() == eCell->getIndexY())
-                {
-                    // The link starts and ends in cells of equal latitude (Y)
-                    for (int j = minX; j <= maxX; j++)
-                        cells[minY][j]->addLink(pLink);
-                }
-                else
-                {
-                    GeoPos* sPos = startNode->getGeoPos();
-                    GeoPos* ePos = endNode->getGeoPos();
-                    double LA = (ePos->getLat() - sPos->getLat()) / (ePos->getLon() - sPos->getLon());
-                    double LB = sPos->getLat() - LA * sPos->getLon();
-
-                    // The link starts and ends in cells of both different longitude (X) and latitude (Y)
-                    for (int j = minX; j <= maxX; j++)
-                    {
-                        for (int i = minY; i <= maxY; i++)
-                        {
-                            Cell* cell = getCell(j, i);
-                            if (cell->getID() != sCell->getID() && cell->getID() != eCell->getID())
-                            {
-                                double cellMinX, cellMinY, cellMaxX, cellMaxY;
-                                cellMinX = cell->getDownLeftPos()->getLon();
-                                cellMaxX = cell->getUpRightPos()->getLon();
-                                cellMinY = cell->getDownLeftPos()->getLat();
-                                cellMaxY = cell->getUpRightPos()->getLat();
-
-                                // For each one of the cell's sides, check if it intersects with the link
-                                double LY = LA * cellMinX + LB;	// Left side, x = minX
-                                if ((LY >= cellMinY) && (LY <= cellMaxY))
-                                        cell->addLink(pLink);
-                                else
-                                {
-                                    LY = LA * cellMaxX + LB;	// Right side, x = maxX
-                                    if ((LY >= cellMinY) && (LY <= cellMaxY))
-                                        cell->addLink(pLink);
-                                    else
-                                    {
-                                        double LX = (cellMinY - LB) / LA;	// Down side, y = minY
-                                        if ((LX >= cellMinX) && (LX <= cellMaxX))
-                                            cell->addLink(pLink);
-                                        else
-                                        {
-                                            LX = (cellMaxY - LB) / LA;	// Up side, y = maxY
-                                            if ((LX >= cellMinX) && (LX <= cellMaxX))
-                                                cell->addLink(pLink);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+                cellOffsets.push_back(static_cast<int>(a));
             }
+            cellIDs.push_back(assignments[a].first);
         }
+        cellLinks[a] = assignments[a].second;
+    }
+    if (!assignments.empty())
+    {
+        cellOffsets.push_back(static_cast<int>(assignments.size()));
+    }
+
+    // The cells are views of their rows of cellLinks
+    GraphStore* store = network->getGraphStore();
+    cells.reserve(cellIDs.size());
+    for (size_t k = 0; k < cellIDs.size(); k++)
+    {
+        Cell cell(cellIDs[k]);
+        int indexX = static_cast<int>(cellIDs[k] % numOfCellsInX);
+        int indexY = static_cast<int>(cellIDs[k] / numOfCellsInX);
+        cell.setIndexX(indexX);
+        cell.setIndexY(indexY);
+        double lat = minLat + indexY * dimension;
+        double lon = minLon + indexX * dimension;
+        cell.setDownLeftPos(GeoPos(lat, lon));
+        cell.setUpRightPos(GeoPos(lat + dimension, lon + dimension));
+        cell.setLinksOfCell(LinkRange(cellLinks.data() + cellOffsets[k], cellLinks.data() + cellOffsets[k + 1], store->getLink(0)));
+        cells.push_back(cell);
     }
 }
 
+bool Grid::getCellIndices(double lat, double lon, int& indexX, int& indexY) const
+{
+    if ((lat >= minLat && lat <= maxLat) && (lon >= minLon && lon <= maxLon))
+    {
+        double dY = lat - minLat;
+        indexY = std::min(static_cast<int>(dY / dimension), numOfCellsInY - 1);
+        double dX = lon - minLon;
+        indexX = std::min(static_cast<int>(dX / dimension), numOfCellsInX - 1);
+        return true;
+    }
+    return false;
+}
+
 Cell* Grid::getCell(int indexX, int indexY) const
 {
     Cell* cell = nullptr;
     if (indexX >= 0 && indexX < numOfCellsInX && indexY >= 0 && indexY < numOfCellsInY)
     {
-        cell = cells[indexY][indexX];
+        int64_t cellID = static_cast<int64_t>(indexY) * numOfCellsInX + indexX;
+        auto it = std::lower_bound(cellIDs.begin(), cellIDs.end(), cellID);
+        if (it != cellIDs.end() && *it == cellID)
+        {
+            cell = const_cast<Cell*>(&cells[it - cellIDs.begin()]);
+        }
     }
     return cell;
 }
 
 Cell* Grid::getCellContainingVDS(VDS* vds) const
 {
-    GeoPos* pos = vds->getGeoPos();
-    double lat = pos->getLat();
-    double lon = pos->getLon();
-    if ((lat >= minLat && lat <= maxLat) && (lon >= minLon && lon <= maxLon))
+    return getCellContainingPos(vds->getGeoPos());
+}
+
+Cell* Grid::getCellContainingNode(Node* node) const
+{
+    GeoPos pos = node->getGeoPos();
+    return getCellContainingPos(&pos);
+}
+
+Cell* Grid::getCellContainingPos(GeoPos* pos) const
+{
+    int indexX = -1;
+    int indexY = -1;
+    if (getCellIndices(pos->getLat(), pos->getLon(), indexX, indexY))
     {
-        double dY = lat - minLat;
-        int i = static_cast<int>(dY / dimension);
-        double dX = lon - minLon;
-        int j = static_cast<int>(dX / dimension);
-        //int cellID = i * numOfCellsInX + j;
-        return cells[i][j];
+        return getCell(indexX, indexY);
     }
     else
     {
@@ -218,26 +284,268 @@ Cell* Grid::getCellContainingVDS(VDS* vds) const
     }
 }
 
-Cell* Grid::getCellContainingNode(Node* node) const
+Link* Grid::findNearestLink(double lon, double lat, double& distance) const
 {
-    return getCellContainingPos(node->getGeoPos());
+    distance = -1.0;
+    if (cells.empty())
+    {
+        return nullptr;
+    }
+    GraphStore* store = network->getGraphStore();
+    // The cell of the point, or the nearest cell of the grid if the point is outside it
+    int centerX = static_cast<int>(std::floor((lon - minLon) / dimension));
+    int centerY = static_cast<int>(std::floor((lat - minLat) / dimension));
+    centerX = std::min(std::max(centerX, 0), numOfCellsInX - 1);
+    centerY = std::min(std::max(centerY, 0), numOfCellsInY - 1);
+    int maxRing = std::max(std::max(centerX, numOfCellsInX - 1 - centerX), std::max(centerY, numOfCellsInY - 1 - centerY));
+
+    int bestLink = -1;
+    double minDistance = std::numeric_limits<double>::infinity();
+    auto visitCell = [&](int indexX, int indexY)
+    {
+        Cell* cell = getCell(indexX, indexY);
+        if (cell == nullptr)
+        {
+            return;
+        }
+        LinkRange linksOfCell = cell->getLinksOfCell();
+        for (size_t k = 0; k < linksOfCell.size(); k++)
+        {
+            int link = linksOfCell.indexAt(k);
+            double linkDistance = store->getLink(link)->calcLinkDistanceFromPoint(lon, lat);
+            // Among links at equal distance the one with the smallest ID wins, as in the exhaustive search
+            if (linkDistance < minDistance || (linkDistance == minDistance && link < bestLink))
+            {
+                minDistance = linkDistance;
+                bestLink = link;
+            }
+        }
+    };
+    // The distance of the point from the columns [firstX, lastX] x rows [firstY, lastY] of the grid, infinite if there are none
+    auto calcCellsDistance = [&](int firstX, int lastX, int firstY, int lastY)
+    {
+        firstX = std::max(firstX, 0);
+        lastX = std::min(lastX, numOfCellsInX - 1);
+        firstY = std::max(firstY, 0);
+        lastY = std::min(lastY, numOfCellsInY - 1);
+        if (firstX > lastX || firstY > lastY)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        // The box is widened a little, so that rounding in the cell indices of the links can never make the bound too large
+        double slack = 1e-9 * dimension;
+        double boxMinLon = minLon + firstX * dimension - slack;
+        double boxMaxLon = minLon + (lastX + 1) * dimension + slack;
+        double boxMinLat = minLat + firstY * dimension - slack;
+        double boxMaxLat = minLat + (lastY + 1) * dimension + slack;
+        double dx = std::max(std::max(boxMinLon - lon, lon - boxMaxLon), 0.0);
+        double dy = std::max(std::max(boxMinLat - lat, lat - boxMaxLat), 0.0);
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        if (ring > 0)
+        {
+            // A link that has not been seen lies only in cells outside the rings visited so far,
+            // i.e. in the four strips left, right, below and above them
+            double bound = std::min(std::min(calcCellsDistance(0, centerX - ring, 0, numOfCellsInY - 1), calcCellsDistance(centerX + ring, numOfCellsInX - 1, 0, numOfCellsInY - 1)),
+                                    std::min(calcCellsDistance(0, numOfCellsInX - 1, 0, centerY - ring), calcCellsDistance(0, numOfCellsInX - 1, centerY + ring, numOfCellsInY - 1)));
+            if (minDistance < bound)
+            {
+                break;
+            }
+        }
+        int firstX = std::max(centerX - ring, 0);
+        int lastX = std::min(centerX + ring, numOfCellsInX - 1);
+        for (int indexX = firstX; indexX <= lastX; indexX++)
+        {
+            visitCell(indexX, centerY - ring);
+            if (ring > 0)
+            {
+                visitCell(indexX, centerY + ring);
+            }
+        }
+        if (ring > 0)
+        {
+            int firstY = std::max(centerY - ring + 1, 0);
+            int lastY = std::min(centerY + ring - 1, numOfCellsInY - 1);
+            for (int indexY = firstY; indexY <= lastY; indexY++)
+            {
+                visitCell(centerX - ring, indexY);
+                visitCell(centerX + ring, indexY);
+            }
+        }
+    }
+    if (bestLink == -1)
+    {
+        return nullptr;
+    }
+    distance = minDistance;
+    return store->getLink(bestLink);
 }
 
-Cell* Grid::getCellContainingPos(GeoPos* pos) const
+int64_t Grid::getNumOfCells() const
 {
-    double lat = pos->getLat();
-    double lon = pos->getLon();
-    if ((lat >= minLat && lat <= maxLat) && (lon >= minLon && lon <= maxLon))
+    return static_cast<int64_t>(numOfCellsInX) * numOfCellsInY;
+}
+
+size_t Grid::getNumOfOccupiedCells() const
+{
+    return cells.size();
+}
+
+void Grid::reportOccupancy() const
+{
+    size_t numOfEmptyCells = 0;
+    size_t numOfOccupiedCells = 0;
+    size_t numOfAssignments = 0;
+    size_t maxLinksPerCell = 0;
+    /*! bucket b counts the cells holding [2^b, 2^(b+1)) links */
+    std::vector<size_t> histogram;
+    for (const auto& cell : cells)
     {
-        double dY = lat - minLat;
-        int i = static_cast<int>(dY / dimension);
-        double dX = lon - minLon;
-        int j = static_cast<int>(dX / dimension);
-        //int cellID = i * numOfCellsInX + j;
-        return cells[i][j];
+        size_t numOfLinks = cell.getLinksOfCell().size();
+        numOfOccupiedCells++;
+        numOfAssignments += numOfLinks;
+        maxLinksPerCell = std::max(maxLinksPerCell, numOfLinks);
+        size_t bucket = 0;
+        while ((numOfLinks >> (bucket + 1)) > 0)
+        {
+            bucket++;
+        }
+        if (histogram.size() <= bucket)
+        {
+            histogram.resize(bucket + 1, 0);
+        }
+        histogram[bucket]++;
     }
-    else
+    numOfEmptyCells = static_cast<size_t>(getNumOfCells()) - numOfOccupiedCells;
+    std::cout << "Cell size: " << dimension << "\n";
+    std::cout << "Empty cells: " << numOfEmptyCells << ", occupied cells: " << numOfOccupiedCells << "\n";
+    if (numOfOccupiedCells > 0)
     {
-        return nullptr;
+        std::cout << "Mean links per occupied cell: " << static_cast<double>(numOfAssignments) / static_cast<double>(numOfOccupiedCells)
+                  << ", max: " << maxLinksPerCell << "\n";
+    }
+    std::cout << "Links per occupied cell:\n";
+    for (size_t bucket = 0; bucket < histogram.size(); bucket++)
+    {
+        size_t first = size_t(1) << bucket;
+        size_t last = (size_t(1) << (bucket + 1)) - 1;
+        std::cout << "  " << first;
+        if (last > first)
+        {
+            std::cout << "-" << last;
+        }
+        std::cout << ": " << histogram[bucket] << "\n";
+    }
+}
+
+double Grid::chooseDimension(Network* network, double targetLinksPerCell, int numThreads)
+{
+    PROFILE_PHASE(phase, "Grid::chooseDimension");
+    if (numThreads <= 0)
+    {
+        numThreads = omp_get_max_threads();
+    }
+    double minLength = 0.0;
+    double maxLength = 0.0;
+    double meanLength = 0.0;
+    network->findMinMaxMeanLengthOfLinks(minLength, maxLength, meanLength);
+
+    GraphStore* store = network->getGraphStore();
+    size_t numOfNodes = store->getNumOfNodes();
+    int numOfLinks = static_cast<int>(store->getNumOfLinks());
+    const double* nodeLons = store->getNodeLons();
+    const double* nodeLats = store->getNodeLats();
+    const int* linkStartNodes = store->getLinkStartNodes();
+    const int* linkEndNodes = store->getLinkEndNodes();
+    double originLon = *std::min_element(nodeLons, nodeLons + numOfNodes);
+    double originLat = *std::min_element(nodeLats, nodeLats + numOfNodes);
+    double extent = std::max(*std::max_element(nodeLons, nodeLons + numOfNodes) - originLon, *std::max_element(nodeLats, nodeLats + numOfNodes) - originLat);
+    if (meanLength <= 0.0 || extent <= 0.0)
+    {
+        /*! All the links are points, any size will do */
+        return std::max(maxLength, 0.001);
+    }
+
+    /*! Only a sample of the cells is counted on large networks: a cell is in the sample if the top sampleBits bits of
+     *  the hash of its index are 0, so that the sample holds the cells of about 64K links whatever the network.
+     *  Every link is still traversed, so the sampled cells are counted exactly and the mean is that of all the cells. */
+    int sampleBits = 0;
+    while (sampleBits < 16 && (static_cast<int64_t>(numOfLinks) >> sampleBits) > (1 << 16))
+    {
+        sampleBits++;
+    }
+    auto isSampled = [sampleBits](int64_t cell)
+    {
+        return sampleBits == 0 || (static_cast<uint64_t>(cell) * 0x9E3779B97F4A7C15ull) >> (64 - sampleBits) == 0;
+    };
+
+    /*! The mean number of links of an occupied cell of the sample for a cell size, with the traversal of assignLinksToGrid() */
+    std::vector< std::vector<int64_t> > threadCells(numThreads);
+    std::vector<int64_t> sampledCells;
+    auto countLinksPerCell = [&](double dimension)
+    {
+        int numOfCells = static_cast<int>(std::ceil(extent / dimension)) + 1;
+#pragma omp parallel num_threads(numThreads)
+        {
+            std::vector<int64_t>& cells = threadCells[omp_get_thread_num()];
+            cells.clear();
+#pragma omp for schedule(static)
+            for (int i = 0; i < numOfLinks; i++)
+            {
+                traverseCells((nodeLons[linkStartNodes[i]] - originLon) / dimension, (nodeLats[linkStartNodes[i]] - originLat) / dimension,
+                    (nodeLons[linkEndNodes[i]] - originLon) / dimension, (nodeLats[linkEndNodes[i]] - originLat) / dimension,
+                    numOfCells, numOfCells, [&](int indexX, int indexY)
+                    {
+                        int64_t cell = static_cast<int64_t>(indexY) * numOfCells + indexX;
+                        if (isSampled(cell))
+                        {
+                            cells.push_back(cell);
+                        }
+                    });
+            }
+        }
+        sampledCells.clear();
+        for (const auto& cells : threadCells)
+        {
+            sampledCells.insert(sampledCells.end(), cells.begin(), cells.end());
+        }
+        size_t numOfAssignments = sampledCells.size();
+        std::sort(sampledCells.begin(), sampledCells.end());
+        size_t numOfOccupiedCells = std::unique(sampledCells.begin(), sampledCells.end()) - sampledCells.begin();
+        /*! An unlucky sample may miss every cell of a coarse grid; the count is then taken as too high */
+        return (numOfOccupiedCells > 0) ? static_cast<double>(numOfAssignments) / static_cast<double>(numOfOccupiedCells) : std::numeric_limits<double>::infinity();
+    };
+
+    /*! The count grows with the size of the cells; a link spans about 8 cells at the lower end of the bracket
+     *  and the whole network is one cell at the upper end. Stop once the bracket is within 1%; the last size
+     *  counted is then within 1% of the target size, and it is chosen so that its count needs no extra pass. */
+    double low = std::min(meanLength / 8.0, extent);
+    double high = extent;
+    double dimension = std::sqrt(low * high);
+    double linksPerCell = 0.0;
+    int numOfSteps = 0;
+    do
+    {
+        dimension = std::sqrt(low * high);
+        linksPerCell = countLinksPerCell(dimension);
+        numOfSteps++;
+        if (linksPerCell < targetLinksPerCell)
+        {
+            low = dimension;
+        }
+        else
+        {
+            high = dimension;
+        }
     }
-}
\ No newline at end of file
+    while (high / low > 1.01);
+    PROFILE_COUNT(phase, "steps", static_cast<size_t>(numOfSteps));
+    PROFILE_COUNT(phase, "sampleBits", static_cast<size_t>(sampleBits));
+    std::cout << "Chosen cell size: " << dimension << " (mean link length: " << meanLength << ", links per occupied cell: "
+              << linksPerCell << ", target: " << targetLinksPerCell << ")\n";
+    return dimension;
+}
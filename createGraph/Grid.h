@@ -8,11 +8,22 @@ class GeoPos;
 class VDS;
 class Node;
 class Network;
+class Link;
 
+/*! The Grid divides the bounding box of the network into square cells. It is sparse: only the cells
+ *  that hold at least one link exist, as Cell objects sorted by ID, and their links are kept in
+ *  compressed sparse row form. A position is mapped to its cell by computing the cell ID and looking
+ *  it up in the sorted IDs, so empty space (ocean, desert) costs no memory whatever the cell size.
+ */
 class Grid
 {
     Network* network;
-    std::vector< std::vector<Cell*> > cells;
+    /*! The IDs of the occupied cells, ascending; cellIDs[k] is the ID of cells[k] */
+    std::vector<int64_t> cellIDs;
+    std::vector<Cell> cells;
+    /*! The links of cells[k] are cellLinks[cellOffsets[k] .. cellOffsets[k + 1]), as dense link indices sorted by ID */
+    std::vector<int> cellOffsets;
+    std::vector<int> cellLinks;
     double dimension;
     double minLat;
     double maxLat;
@@ -20,6 +31,13 @@ class Grid
     double maxLon;
     int numOfCellsInX;
     int numOfCellsInY;
+
+    /*! Computes the indices of the cell containing a position
+     *  @return false if the position is outside the grid
+     */
+    bool getCellIndices(double lat, double lon, int& indexX, int& indexY) const;
+    /*! Creates the occupied cells and their link lists from (cell ID, dense link index) pairs */
+    void createCells(std::vector< std::pair<int64_t, int> >& assignments);
 public:
     /*! Default constructor */
     Grid();
@@ -29,15 +47,49 @@ public:
     ~Grid();
 
     /*! Setters - Getters */
+    /*! The lookups return nullptr for a position outside the grid, and also for a cell without links
+     *  since such a cell does not exist; to a search both mean that there is nothing there. */
     Cell* getCell(int indexX, int indexY) const;
     Cell* getCellContainingPos(GeoPos* pos) const;
     Cell* getCellContainingVDS(VDS* vds) const;
     Cell* getCellContainingNode(Node* node) const;
+    /*! The number of cells in the bounding box, empty or not */
+    int64_t getNumOfCells() const;
+    /*! The number of cells that hold links */
+    size_t getNumOfOccupiedCells() const;
     
     /*! Other functions */
     void build();
-    void assignLinksToGrid();
+    /*! Assigns every link to the cells it crosses, found by a supercover line traversal, i.e. in O(w + h)
+     *  cells for a link spanning w x h cells. The links are rasterised in parallel into per-thread buffers.
+     *  @param numThreads the number of OpenMP threads, 0 means the OpenMP default
+     */
+    void assignLinksToGrid(int numThreads = 0);
     void assignVDSToGrid();
+    /*! Finds the link that is nearest to a point, as measured by Link::calcLinkDistanceFromPoint().
+     *  The cells are visited in square rings of growing size around the cell of the point, and the search
+     *  stops as soon as the nearest link found is nearer than every cell outside the visited rings. Since a
+     *  link is assigned to every cell it crosses, the answer is exact, also when the cell of the point is
+     *  empty or the point lies outside the grid. Among links at equal distance the one with the smallest
+     *  ID is returned, as the exhaustive search does.
+     *  @param lon the longitude of the point
+     *  @param lat the latitude of the point
+     *  @param distance set to the distance of the returned link from the point
+     *  @return the nearest link, or nullptr if the grid holds no links
+     */
+    Link* findNearestLink(double lon, double lat, double& distance) const;
+    /*! Prints the number of empty and occupied cells and a histogram of the number of links per occupied cell,
+     *  in power-of-two buckets, after assignLinksToGrid() */
+    void reportOccupancy() const;
+
+    /*! Chooses the size of the cells so that an occupied cell holds targetLinksPerCell links on average.
+     *  For a candidate size the links are traversed in parallel as by assignLinksToGrid() and the occupied cells
+     *  are counted, on a hashed sample of the cells for networks of more than 64K links; the size is found by
+     *  bisection on a logarithmic scale, between an eighth of the mean link length and the extent of the network.
+     *  @param numThreads the number of OpenMP threads, 0 means the OpenMP default
+     *  @return the chosen size of the cells, in degrees
+     */
+    static double chooseDimension(Network* network, double targetLinksPerCell, int numThreads = 0);
 };
 
 #endif  //  GRID_H
\ No newline at end of file
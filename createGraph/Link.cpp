@@ -1,160 +1,146 @@
 #include "Link.h"
 #include "Node.h"
 #include "MathFunc.h"
+#include "GraphStore.h"
 
-Link::Link() : NetworkElement(-1), startNode(nullptr), endNode(nullptr), length(0.0), direction(oneway), oppositeLink(nullptr), roadOfLink(nullptr)
+Link::Link() : NetworkElement(-1), store(nullptr), index(-1)
 {
 }
 
-Link::Link(int ID, Node* _startNode, Node* _endNode) : NetworkElement(ID), startNode(_startNode), endNode(_endNode), length(0.0), direction(oneway), oppositeLink(nullptr), roadOfLink(nullptr)
+Link::Link(GraphStore* _store, int _index) : NetworkElement(_store->getLinkID(_index)), store(_store), index(_index)
 {
 }
 
+/*! The data of the link belongs to the GraphStore, so there is nothing to free here. */
 Link::~Link()
 {
-    if (!beforeInLinks.empty())
-    {
-        beforeInLinks.clear();
-    }
-    if (!beforeOutLinks.empty())
-    {
-        beforeOutLinks.clear();
-    }
-    if (!afterInLinks.empty())
-    {
-        afterInLinks.clear();
-    }
-    if (!afterOutLinks.empty())
-    {
-        afterOutLinks.clear();
-    }
 }
 
-Link::Link(const Link& link) : NetworkElement(link.ID), startNode(link.startNode), endNode(link.endNode), length(link.length), direction(link.direction), oppositeLink(link.oppositeLink), roadOfLink(link.roadOfLink)
+Link::Link(const Link& link) : NetworkElement(link.ID), store(link.store), index(link.index)
 {
 }
 
 Link& Link::operator=(const Link& link)
 {
     ID = link.ID;
-    startNode = link.startNode;
-    endNode = link.endNode;
-    length = link.length; 
-    direction = link.direction;
-    oppositeLink = link.oppositeLink;
-    roadOfLink = link.roadOfLink;
+    store = link.store;
+    index = link.index;
     return *this;
 }
 
-void Link::setNodes(Node* _startNode, Node* _endNode)
-{
-    startNode = _startNode;
-    endNode = _endNode;
-}
-
-void Link::getNodes(Node* _startNode, Node* _endNode) const
+int Link::getIndex() const
 {
-    _startNode = startNode;
-    _endNode = endNode;
+    return index;
 }
 
 Node* Link::getStartNode() const
 {
-    return startNode;
+    return store->getNode(store->getLinkStartNode(index));
 }
 
 Node* Link::getEndNode() const
 {
-    return endNode;
+    return store->getNode(store->getLinkEndNode(index));
 }
 
 void Link::setLength(const double _length)
 {
-    length = _length;
+    store->setLinkLength(index, _length);
 }
 
 double Link::getLength() const
 {
-    return length;
+    return store->getLinkLength(index);
 }
 
 void Link::setDirection(const Direction _direction)
 {
-    direction = _direction;
+    store->setLinkDirection(index, _direction);
 }
 
 Direction Link::getDirection() const
 {
-    return direction;
+    return store->getLinkDirection(index);
 }
 
 void Link::setOppositeLink(Link* _oppositeLink)
 {
-    oppositeLink = _oppositeLink;
+    store->setOppositeLink(index, (_oppositeLink != nullptr) ? _oppositeLink->index : -1);
 }
 
 Link* Link::getOppositeLink() const
 {
-    return oppositeLink;
+    int oppositeLink = store->getOppositeLink(index);
+    return (oppositeLink != -1) ? store->getLink(oppositeLink) : nullptr;
 }
 
-LinkMap* Link::getBeforeInLinks()
+LinkRange Link::getBeforeInLinks()
 {
-    return &beforeInLinks;
+    return store->getNeighbourLinks(index, 0);
 }
 
-LinkMap* Link::getBeforeOutLinks()
+LinkRange Link::getBeforeOutLinks()
 {
-    return &beforeOutLinks;
+    return store->getNeighbourLinks(index, 1);
 }
 
-LinkMap* Link::getAfterInLinks()
+LinkRange Link::getAfterInLinks()
 {
-    return &afterInLinks;
+    return store->getNeighbourLinks(index, 2);
 }
 
-LinkMap* Link::getAfterOutLinks()
+LinkRange Link::getAfterOutLinks()
 {
-    return &afterOutLinks;
+    return store->getNeighbourLinks(index, 3);
 }
 
 size_t Link::getNumOfBeforeInLinks() 
 {
-    return beforeInLinks.size();
+    return getBeforeInLinks().size();
 }
 
 size_t Link::getNumOfBeforeOutLinks()
 {
-    return beforeOutLinks.size();
+    return getBeforeOutLinks().size();
 }
 
 size_t Link::getNumOfAfterInLinks()
 {
-    return afterInLinks.size();
+    return getAfterInLinks().size();
 }
 
 size_t Link::getNumOfAfterOutLinks()
 {
-    return afterOutLinks.size();
+    return getAfterOutLinks().size();
 }
+
 void Link::setRoadOfLink(Road* _roadOfLink)
 {
-    roadOfLink = _roadOfLink;
+    store->setLinkRoad(index, _roadOfLink);
 }
 
 Road* Link::getRoadOfLink() const 
 {
-    return roadOfLink;
+    return store->getLinkRoad(index);
 }
 
 void Link::computeLength()
 {
-    length = mfnc::calcPointsDistance(startNode->getLon(), startNode->getLat(), endNode->getLon(), endNode->getLat());
+    int startNode = store->getLinkStartNode(index);
+    int endNode = store->getLinkEndNode(index);
+    store->setLinkLength(index, mfnc::calcPointsDistance(store->getNodeLon(startNode), store->getNodeLat(startNode), store->getNodeLon(endNode), store->getNodeLat(endNode)));
 }
 
 /*! Distance between link and point (implementation 1) */
 /*! Refer to 2002_Greenfeld, equations (1)-(4) */
 double Link::calcLinkDistanceFromPoint(double pointX, double pointY)
+{
+    double projX = 0.0;
+    double projY = 0.0;
+    return calcLinkDistanceFromPoint(pointX, pointY, projX, projY);
+}
+
+double Link::calcLinkDistanceFromPoint(double pointX, double pointY, double& projX, double& projY)
 {
     // verX and verY stand for vertical X and vertical Y. 
     // They are the coordinates of the vertical projection of point on the Link.
@@ -165,10 +151,14 @@ double Link::calcLinkDistanceFromPoint(double pointX, double pointY)
     double distS = 0.0;
     double distE = 0.0;
 
-    double startNodeLon = startNode->getLon();
-    double startNodeLat = startNode->getLat();
-    double endNodeLon = endNode->getLon();
-    double endNodeLat = endNode->getLat();
+    const double* nodeLons = store->getNodeLons();
+    const double* nodeLats = store->getNodeLats();
+    int startNode = store->getLinkStartNode(index);
+    int endNode = store->getLinkEndNode(index);
+    double startNodeLon = nodeLons[startNode];
+    double startNodeLat = nodeLats[startNode];
+    double endNodeLon = nodeLons[endNode];
+    double endNodeLat = nodeLats[endNode];
 
     double minLon = std::min(startNodeLon, endNodeLon);
     double maxLon = std::max(startNodeLon, endNodeLon);
@@ -180,22 +170,13 @@ double Link::calcLinkDistanceFromPoint(double pointX, double pointY)
         if (endNodeLat == startNodeLat) // The link is a point and so the distance is the distance between two points
         {
             distance = mfnc::calcPointsDistance(startNodeLon, startNodeLat, pointX, pointY);
+            projX = startNodeLon;
+            projY = startNodeLat;
+            return distance;
         }
-        else    // The link is parallel to the y-axis
-        {
-            verX = startNodeLon;
-            verY = pointY;
-            if ((verX >= minLon) && (verX <= maxLon) && (verY >= minLat) && (verY <= maxLat))
-            {
-                distance = mfnc::calcPointsDistance(verX, verY, pointX, pointY);
-            }
-            else
-            {
-                distS = mfnc::calcPointsDistance(pointX, pointY, startNodeLon, startNodeLat);
-                distE = mfnc::calcPointsDistance(pointX, pointY, endNodeLon, endNodeLat);
-                distance = std::min(distS, distE);
-            }
-        }
+        // The link is parallel to the y-axis
+        verX = startNodeLon;
+        verY = pointY;
     }
     else
     {
@@ -203,55 +184,37 @@ double Link::calcLinkDistanceFromPoint(double pointX, double pointY)
         m = (endNodeLat - startNodeLat) / (endNodeLon - startNodeLon);
         verX = (m * (pointY - startNodeLat + m * startNodeLon) + pointX) / (m * m + 1.0);
         verY = startNodeLat + m * (verX - startNodeLon);
-        if ((verX >= minLon) && (verX <= maxLon) && (verY >= minLat) && (verY <= maxLat))
+    }
+    if ((verX >= minLon) && (verX <= maxLon) && (verY >= minLat) && (verY <= maxLat))
+    {
+        distance = mfnc::calcPointsDistance(verX, verY, pointX, pointY);
+        projX = verX;
+        projY = verY;
+    }
+    else
+    {
+        // The projection falls outside the link, so the nearest point of the link is one of its nodes
+        distS = mfnc::calcPointsDistance(pointX, pointY, startNodeLon, startNodeLat);
+        distE = mfnc::calcPointsDistance(pointX, pointY, endNodeLon, endNodeLat);
+        if (distE < distS)
         {
-            distance = mfnc::calcPointsDistance(verX, verY, pointX, pointY);
+            distance = distE;
+            projX = endNodeLon;
+            projY = endNodeLat;
         }
         else
         {
-            distS = mfnc::calcPointsDistance(pointX, pointY, startNodeLon, startNodeLat);
-            distE = mfnc::calcPointsDistance(pointX, pointY, endNodeLon, endNodeLat);
-            distance = std::min(distS, distE);
+            distance = distS;
+            projX = startNodeLon;
+            projY = startNodeLat;
         }
-    }       
+    }
     return distance;
 }
 
-void Link::addBeforeInLink(const int beforeInLinkID, Link* beforeInLink)
-{
-   if (beforeInLinks.find(beforeInLinkID) == beforeInLinks.end())
-   {
-       beforeInLinks.insert(std::make_pair(beforeInLinkID, beforeInLink));
-   }
-}
-
-void Link::addBeforeOutLink(const int beforeOutLinkID, Link* beforeOutLink)
-{
-   if (beforeOutLinks.find(beforeOutLinkID) == beforeOutLinks.end())
-   {
-       beforeOutLinks.insert(std::make_pair(beforeOutLinkID, beforeOutLink));
-   }
-}
-
-void Link::addAfterInLink(const int afterInLinkID, Link* afterInLink)
-{
-   if (afterInLinks.find(afterInLinkID) == afterInLinks.end())
-   {
-       afterInLinks.insert(std::make_pair(afterInLinkID, afterInLink));
-   }
-}
-
-void Link::addAfterOutLink(const int afterOutLinkID, Link* afterOutLink)
-{
-   if (afterOutLinks.find(afterOutLinkID) == afterOutLinks.end())
-   {
-       afterOutLinks.insert(std::make_pair(afterOutLinkID, afterOutLink));
-   }
-}
-
 bool Link::isOppositeOf(Link *pLink)
 {
-    if (oppositeLink == pLink)
+    if (getOppositeLink() == pLink)
     {
         return true;
     }
@@ -6,25 +6,22 @@
 
 class Node;
 class Road;
+class GraphStore;
 
+/*! A directed link of the network. It is a thin view of one link of the GraphStore:
+ *  its nodes, length, direction, opposite link and road are kept in the arrays of the store.
+ */
 class Link : public NetworkElement
 {
-    Node* startNode;
-    Node* endNode;
-    double length;
-    Direction direction;
-    Link* oppositeLink;
-    Road* roadOfLink;
-    /*! neighbors */
-    LinkMap beforeInLinks;
-    LinkMap beforeOutLinks;
-    LinkMap afterInLinks;
-    LinkMap afterOutLinks;
+    /*! The store holding the data of the link */
+    GraphStore* store;
+    /*! The dense index of the link in the store */
+    int index;
 public:
     /*! Default constructor */
     Link();
     /*! Constructor */
-    Link(int ID, Node* _startNode, Node* _endNode);	
+    Link(GraphStore* _store, int _index);
     /*! Destructor */
     ~Link();
     /*! Copy-constructor */
@@ -33,8 +30,7 @@ public:
     Link& operator=(const Link& link);
 
     /*! Setters - Getters */
-    void setNodes(Node* _startNode, Node* _endNode);
-    void getNodes(Node* _startNode, Node* _endNode) const;
+    int getIndex() const;
     Node* getStartNode() const;
     Node* getEndNode() const;
     void setLength(const double _length);
@@ -43,10 +39,12 @@ public:
     Direction getDirection() const;
     void setOppositeLink(Link* _oppositeLink);
     Link* getOppositeLink() const;
-    LinkMap* getBeforeInLinks();
-    LinkMap* getBeforeOutLinks();
-    LinkMap* getAfterInLinks();
-    LinkMap* getAfterOutLinks();
+    /*! The neighbours of the link, i.e. the other links of its start node (before) and of its end node (after),
+     *  as views of the neighbourhood arrays of the store */
+    LinkRange getBeforeInLinks();
+    LinkRange getBeforeOutLinks();
+    LinkRange getAfterInLinks();
+    LinkRange getAfterOutLinks();
     size_t getNumOfBeforeInLinks();
     size_t getNumOfBeforeOutLinks();
     size_t getNumOfAfterInLinks();
@@ -63,10 +61,15 @@ public:
      */
     void computeLength();
     double calcLinkDistanceFromPoint(double pointX, double pointY);
-    void addBeforeInLink(const int beforeInLinkID, Link* beforeInLink);
-    void addBeforeOutLink(const int beforeOutLinkID, Link* beforeOutLink);
-    void addAfterInLink(const int afterInLinkID, Link* afterInLink);
-    void addAfterOutLink(const int afterOutLinkID, Link* afterOutLink);
+    /*!
+     * Returns the distance of a point from the link and the point of the link that is nearest to it.
+     * @param pointX the longitude of the point
+     * @param pointY the latitude of the point
+     * @param projX set to the longitude of the nearest point of the link
+     * @param projY set to the latitude of the nearest point of the link
+     * @return the distance of the point from the link
+     */
+    double calcLinkDistanceFromPoint(double pointX, double pointY, double& projX, double& projY);
     bool isOppositeOf(Link *pLink);
 
 //    bool IsPointCovered(double pointX, double pointY);
@@ -0,0 +1,174 @@
+#include "LinkSegments.h"
+#include "GraphStore.h"
+
+#include <immintrin.h>
+
+/*! Measured differences stay below 1e-14 * (1 + |slope|) for points and links in [-125, -115] x [32, 40];
+ *  the constant leaves a margin of two orders of magnitude. */
+const double LinkSegments::tolerance = 1e-12;
+
+namespace
+{
+    typedef void (*DistanceKernel)(const double*, const double*, const double*, const double*, double, double, int, double*);
+
+    void calcDistancesScalar(const double* sx, const double* sy, const double* ex, const double* ey, double px, double py, int n, double* distances)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            double dx = ex[i] - sx[i];
+            double dy = ey[i] - sy[i];
+            double length2 = dx * dx + dy * dy;
+            double dot = (px - sx[i]) * dx + (py - sy[i]) * dy;
+            double t = (length2 > 0.0) ? dot / length2 : 0.0;
+            t = std::min(std::max(t, 0.0), 1.0);
+            double projX = (t <= 0.0) ? sx[i] : ((t >= 1.0) ? ex[i] : sx[i] + t * dx);
+            double projY = (t <= 0.0) ? sy[i] : ((t >= 1.0) ? ey[i] : sy[i] + t * dy);
+            double rx = px - projX;
+            double ry = py - projY;
+            distances[i] = std::sqrt(rx * rx + ry * ry);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void calcDistancesAVX2(const double* sx, const double* sy, const double* ex, const double* ey, double px, double py, int n, double* distances)
+    {
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d vpx = _mm256_set1_pd(px);
+        const __m256d vpy = _mm256_set1_pd(py);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256d vsx = _mm256_loadu_pd(sx + i);
+            __m256d vsy = _mm256_loadu_pd(sy + i);
+            __m256d vex = _mm256_loadu_pd(ex + i);
+            __m256d vey = _mm256_loadu_pd(ey + i);
+            __m256d dx = _mm256_sub_pd(vex, vsx);
+            __m256d dy = _mm256_sub_pd(vey, vsy);
+            __m256d length2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            __m256d dot = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(vpx, vsx), dx), _mm256_mul_pd(_mm256_sub_pd(vpy, vsy), dy));
+            __m256d t = _mm256_blendv_pd(zero, _mm256_div_pd(dot, length2), _mm256_cmp_pd(length2, zero, _CMP_GT_OQ));
+            t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
+            __m256d atStart = _mm256_cmp_pd(t, zero, _CMP_LE_OQ);
+            __m256d atEnd = _mm256_cmp_pd(t, one, _CMP_GE_OQ);
+            __m256d projX = _mm256_add_pd(vsx, _mm256_mul_pd(t, dx));
+            __m256d projY = _mm256_add_pd(vsy, _mm256_mul_pd(t, dy));
+            projX = _mm256_blendv_pd(_mm256_blendv_pd(projX, vex, atEnd), vsx, atStart);
+            projY = _mm256_blendv_pd(_mm256_blendv_pd(projY, vey, atEnd), vsy, atStart);
+            __m256d rx = _mm256_sub_pd(vpx, projX);
+            __m256d ry = _mm256_sub_pd(vpy, projY);
+            _mm256_storeu_pd(distances + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(rx, rx), _mm256_mul_pd(ry, ry))));
+        }
+        calcDistancesScalar(sx + i, sy + i, ex + i, ey + i, px, py, n - i, distances + i);
+    }
+
+    __attribute__((target("avx512f")))
+    void calcDistancesAVX512(const double* sx, const double* sy, const double* ex, const double* ey, double px, double py, int n, double* distances)
+    {
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d one = _mm512_set1_pd(1.0);
+        const __m512d vpx = _mm512_set1_pd(px);
+        const __m512d vpy = _mm512_set1_pd(py);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m512d vsx = _mm512_loadu_pd(sx + i);
+            __m512d vsy = _mm512_loadu_pd(sy + i);
+            __m512d vex = _mm512_loadu_pd(ex + i);
+            __m512d vey = _mm512_loadu_pd(ey + i);
+            __m512d dx = _mm512_sub_pd(vex, vsx);
+            __m512d dy = _mm512_sub_pd(vey, vsy);
+            __m512d length2 = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+            __m512d dot = _mm512_add_pd(_mm512_mul_pd(_mm512_sub_pd(vpx, vsx), dx), _mm512_mul_pd(_mm512_sub_pd(vpy, vsy), dy));
+            __m512d t = _mm512_maskz_div_pd(_mm512_cmp_pd_mask(length2, zero, _CMP_GT_OQ), dot, length2);
+            t = _mm512_min_pd(_mm512_max_pd(t, zero), one);
+            __mmask8 atStart = _mm512_cmp_pd_mask(t, zero, _CMP_LE_OQ);
+            __mmask8 atEnd = _mm512_cmp_pd_mask(t, one, _CMP_GE_OQ);
+            __m512d projX = _mm512_add_pd(vsx, _mm512_mul_pd(t, dx));
+            __m512d projY = _mm512_add_pd(vsy, _mm512_mul_pd(t, dy));
+            projX = _mm512_mask_blend_pd(atStart, _mm512_mask_blend_pd(atEnd, projX, vex), vsx);
+            projY = _mm512_mask_blend_pd(atStart, _mm512_mask_blend_pd(atEnd, projY, vey), vsy);
+            __m512d rx = _mm512_sub_pd(vpx, projX);
+            __m512d ry = _mm512_sub_pd(vpy, projY);
+            _mm512_storeu_pd(distances + i, _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(rx, rx), _mm512_mul_pd(ry, ry))));
+        }
+        calcDistancesScalar(sx + i, sy + i, ex + i, ey + i, px, py, n - i, distances + i);
+    }
+
+    /*! The widest kernel the processor supports, chosen once */
+    DistanceKernel selectKernel(const char*& instructionSet)
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            instructionSet = "avx512";
+            return calcDistancesAVX512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            instructionSet = "avx2";
+            return calcDistancesAVX2;
+        }
+        instructionSet = "scalar";
+        return calcDistancesScalar;
+    }
+
+    const char* kernelInstructionSet = "scalar";
+    const DistanceKernel kernel = selectKernel(kernelInstructionSet);
+}
+
+LinkSegments::LinkSegments()
+{
+}
+
+LinkSegments::~LinkSegments()
+{
+}
+
+void LinkSegments::build(const GraphStore* store)
+{
+    size_t numOfLinks = store->getNumOfLinks();
+    const double* nodeLons = store->getNodeLons();
+    const double* nodeLats = store->getNodeLats();
+    const int* linkStartNodes = store->getLinkStartNodes();
+    const int* linkEndNodes = store->getLinkEndNodes();
+    startLons.resize(numOfLinks);
+    startLats.resize(numOfLinks);
+    endLons.resize(numOfLinks);
+    endLats.resize(numOfLinks);
+    tolerances.resize(numOfLinks);
+    for (size_t i = 0; i < numOfLinks; i++)
+    {
+        startLons[i] = nodeLons[linkStartNodes[i]];
+        startLats[i] = nodeLats[linkStartNodes[i]];
+        endLons[i] = nodeLons[linkEndNodes[i]];
+        endLats[i] = nodeLats[linkEndNodes[i]];
+        /*! A vertical link is handled as a special case by the reference, without the slope */
+        double dx = endLons[i] - startLons[i];
+        double slope = (dx != 0.0) ? std::fabs((endLats[i] - startLats[i]) / dx) : 0.0;
+        tolerances[i] = tolerance * (1.0 + slope);
+    }
+}
+
+size_t LinkSegments::size() const
+{
+    return startLons.size();
+}
+
+double LinkSegments::getTolerance(const int link) const
+{
+    return tolerances[link];
+}
+
+void LinkSegments::calcDistancesFromPoint(double lon, double lat, int first, int last, double* distances) const
+{
+    if (last > first)
+    {
+        kernel(startLons.data() + first, startLats.data() + first, endLons.data() + first, endLats.data() + first, lon, lat, last - first, distances);
+    }
+}
+
+const char* LinkSegments::getInstructionSet()
+{
+    return kernelInstructionSet;
+}
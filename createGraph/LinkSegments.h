@@ -0,0 +1,61 @@
+#ifndef LINKSEGMENTS_H
+#define LINKSEGMENTS_H
+
+#include "DataTypes.h"
+
+class GraphStore;
+
+/*! This class packs the links of a GraphStore as line segments in structure-of-arrays form
+ *  (start and end coordinates of link i at position i), so that the distance of one point from a
+ *  whole block of links can be computed with SIMD instructions.
+ *
+ *  The kernel uses the branch-free clamped-projection formulation: the projection parameter
+ *  t = ((P - S) . (E - S)) / |E - S|^2 is clamped to [0, 1] (0 for a link whose nodes coincide) and the
+ *  distance is |P - (S + t (E - S))|, with the node itself taken when t is clamped. It is evaluated with
+ *  AVX-512 or AVX2 when the processor supports them (checked once at run time), and with scalar code
+ *  otherwise; the vector kernels do the same operations in the same order as the scalar one.
+ *
+ *  Link::calcLinkDistanceFromPoint() remains the reference. It goes through the slope of the link, so
+ *  it loses precision on almost vertical links, and the two agree within getTolerance(link), i.e.
+ *  tolerance * (1 + |slope|). A search that needs the exact answer of the reference evaluates it only
+ *  for the links whose kernel distance minus their tolerance does not exceed the smallest kernel distance
+ *  plus tolerance.
+ */
+class LinkSegments
+{
+    std::vector<double> startLons;
+    std::vector<double> startLats;
+    std::vector<double> endLons;
+    std::vector<double> endLats;
+    /*! The tolerance of every link */
+    std::vector<double> tolerances;
+public:
+    /*! The maximum absolute difference (in degrees) between the kernel and Link::calcLinkDistanceFromPoint()
+     *  for a link of slope 0, with coordinates within the range of longitudes and latitudes */
+    static const double tolerance;
+
+    /*! Default constructor */
+    LinkSegments();
+    /*! Destructor */
+    ~LinkSegments();
+
+    /*! Packs all the links of the store, by dense index */
+    void build(const GraphStore* store);
+
+    /*! Setters - Getters */
+    size_t size() const;
+    /*! The maximum absolute difference between the kernel and Link::calcLinkDistanceFromPoint() for a link */
+    double getTolerance(const int link) const;
+
+    /*! Computes the distance of a point from the links [first, last)
+     *  @param lon the longitude of the point
+     *  @param lat the latitude of the point
+     *  @param distances set to the distance of link first + k at position k
+     */
+    void calcDistancesFromPoint(double lon, double lat, int first, int last, double* distances) const;
+
+    /*! The name of the instruction set the kernel runs with on this machine: "avx512", "avx2" or "scalar" */
+    static const char* getInstructionSet();
+};
+
+#endif  //  LINKSEGMENTS_H
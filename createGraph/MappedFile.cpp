@@ -0,0 +1,92 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : filename(""), fd(-1), data(nullptr), size(0)
+{
+}
+
+MappedFile::MappedFile(std::string _filename) : filename(_filename), fd(-1), data(nullptr), size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open()
+{
+    close();
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        /*! Pipes and devices report no usable size, leave them to the stream readers.
+            This is checked before opening, since opening a pipe would consume its writer. */
+        return false;
+    }
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size == 0)
+    {
+        /*! mmap() refuses empty mappings, an empty file is simply an empty range */
+        return true;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    /*! The file is read front to back, so tell the kernel to read ahead aggressively */
+    madvise(addr, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(addr);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        munmap(const_cast<char*>(data), size);
+        data = nullptr;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+    return fd >= 0;
+}
+
+const char* MappedFile::getData() const
+{
+    return data;
+}
+
+const char* MappedFile::getEnd() const
+{
+    return data + size;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size;
+}
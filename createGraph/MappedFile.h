@@ -0,0 +1,49 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "DataTypes.h"
+
+/*! This class maps a file read-only into the address space of the process.
+ *  The contents of the file can then be parsed in place, without copying them into std::string objects.
+ */
+class MappedFile
+{
+    /*! The name of the mapped file */
+    std::string filename;
+    /*! The file descriptor of the mapped file */
+    int fd;
+    /*! The first byte of the mapping */
+    const char* data;
+    /*! The size of the mapping in bytes */
+    size_t size;
+public:
+    /*! Default constructor */
+    MappedFile();
+    /*! Constructor */
+    MappedFile(std::string _filename);
+    /*! Destructor */
+    ~MappedFile();
+    /*! A mapping is owned by exactly one object, hence copying is not allowed */
+    MappedFile(const MappedFile& mappedFile) = delete;
+    MappedFile& operator=(const MappedFile& mappedFile) = delete;
+
+    /*! Maps the file into memory
+     *  @param nothing
+     *  @return true if the file has been mapped, false otherwise
+     */
+    bool open();
+
+    /*! Unmaps the file and closes its descriptor
+     *  @param nothing
+     *  @return nothing
+     */
+    void close();
+
+    /*! Setters - Getters */
+    bool isOpen() const;
+    const char* getData() const;
+    const char* getEnd() const;
+    size_t getSize() const;
+};
+
+#endif  //  MAPPEDFILE_H
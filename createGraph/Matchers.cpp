@@ -0,0 +1,200 @@
+#include <omp.h>
+
+#include "Matchers.h"
+#include "Network.h"
+#include "VDS.h"
+#include "Grid.h"
+#include "Link.h"
+#include "RTree.h"
+#include "LinkSegments.h"
+#include "GraphStore.h"
+#include "TimingReport.h"
+
+/*! VDS are matched in blocks of this many against tiles of this many links, so that the packed
+ *  coordinates of a tile (4 x 8 bytes per link) stay in the L2 cache while a whole block is scanned */
+const int greedyVDSBlockSize = 64;
+const int greedyLinkTileSize = 4096;
+
+void findLinksOfVDS_Greedy(Network* network, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report)
+{
+    GraphStore* store = network->getGraphStore();
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    linkOfVDS.assign(numOfVDS, -1);
+
+    double start = omp_get_wtime();
+    // The links packed for the batched distance kernel
+    LinkSegments segments;
+    segments.build(store);
+    int numOfLinks = static_cast<int>(segments.size());
+    int numOfBlocks = (numOfVDS + greedyVDSBlockSize - 1) / greedyVDSBlockSize;
+
+#pragma omp parallel num_threads(numThreads)
+    {
+        std::vector<double> distances(greedyLinkTileSize);
+        // Per VDS of the block: an upper bound of the distance of its nearest link, and the links that may be nearer than it
+        std::vector<double> bounds(greedyVDSBlockSize);
+        std::vector< std::vector< std::pair<double, int> > > candidates(greedyVDSBlockSize);
+#pragma omp for schedule(dynamic, 1)
+        for (int block = 0; block < numOfBlocks; block++)
+        {
+            int firstVDS = block * greedyVDSBlockSize;
+            int lastVDS = std::min(firstVDS + greedyVDSBlockSize, numOfVDS);
+            for (int v = firstVDS; v < lastVDS; v++)
+            {
+                bounds[v - firstVDS] = std::numeric_limits<double>::infinity();
+                candidates[v - firstVDS].clear();
+            }
+            for (int firstLink = 0; firstLink < numOfLinks; firstLink += greedyLinkTileSize)
+            {
+                int lastLink = std::min(firstLink + greedyLinkTileSize, numOfLinks);
+                for (int v = firstVDS; v < lastVDS; v++)
+                {
+                    VDS* point = vds->at(v);
+                    double& bound = bounds[v - firstVDS];
+                    std::vector< std::pair<double, int> >& candidatesOfVDS = candidates[v - firstVDS];
+                    segments.calcDistancesFromPoint(point->getLon(), point->getLat(), firstLink, lastLink, distances.data());
+                    for (int i = firstLink; i < lastLink; i++)
+                    {
+                        bound = std::min(bound, distances[i - firstLink] + segments.getTolerance(i));
+                    }
+                    // Keep the links whose kernel distance is within the tolerances of the smallest one so far
+                    size_t kept = 0;
+                    for (const auto& candidate : candidatesOfVDS)
+                    {
+                        if (candidate.first <= bound)
+                        {
+                            candidatesOfVDS[kept++] = candidate;
+                        }
+                    }
+                    candidatesOfVDS.resize(kept);
+                    for (int i = firstLink; i < lastLink; i++)
+                    {
+                        double lowerBound = distances[i - firstLink] - segments.getTolerance(i);
+                        if (lowerBound <= bound)
+                        {
+                            candidatesOfVDS.push_back(std::make_pair(lowerBound, i));
+                        }
+                    }
+                }
+            }
+            // The nearest link by the reference distance; the candidates are in index order, so ties go to the smallest ID
+            for (int v = firstVDS; v < lastVDS; v++)
+            {
+                VDS* point = vds->at(v);
+                double minDistance = std::numeric_limits<double>::infinity();
+                for (const auto& candidate : candidates[v - firstVDS])
+                {
+                    if (candidate.first <= bounds[v - firstVDS])
+                    {
+                        double distance = store->getLink(candidate.second)->calcLinkDistanceFromPoint(point->getLon(), point->getLat());
+                        if (distance < minDistance)
+                        {
+                            minDistance = distance;
+                            linkOfVDS[v] = candidate.second;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    double end = omp_get_wtime();
+    std::cout << "Elapsed time: " << end - start << std::endl;
+    if (report != nullptr)
+    {
+        report->addPhase("greedy.match", end - start);
+    }
+}
+
+void findLinksOfVDS_PIC(Network* network, double dimension, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report)
+{
+    // Create Grid
+    double gridStart = omp_get_wtime();
+    Grid* grid = new Grid(dimension, network);
+    grid->build();
+    // Assign links to Grid
+    grid->assignLinksToGrid(numThreads);
+    double gridEnd = omp_get_wtime();
+    grid->reportOccupancy();
+    // Match VDS to links
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    // One output slot per VDS (by dense index), -1 meaning not matched.
+    // Every iteration writes only its own slot, so the threads never have to synchronise.
+    linkOfVDS.assign(numOfVDS, -1);
+
+/********************************************************************************** Parallel section ******************************************************************************************************/
+    double start = omp_get_wtime();
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+    for (int i = 0; i < numOfVDS; i++)
+    {
+        VDS* v = vds->at(i);
+        double distance = -1.0;
+        Link* link = grid->findNearestLink(v->getLon(), v->getLat(), distance);
+        if (link != nullptr)
+        {
+            linkOfVDS[i] = link->getIndex();
+        }
+    }
+    double end = omp_get_wtime();
+/********************************************************************************** End of parallel section ***********************************************************************************************/
+    std::cout << "Elapsed time: " << end - start << std::endl;
+    if (report != nullptr)
+    {
+        report->addPhase("pic.grid", gridEnd - gridStart);
+        report->addPhase("pic.match", end - start);
+    }
+
+    delete grid;
+}
+
+void findLinksOfVDS_RTree(Network* network, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report)
+{
+    // Create R-tree
+    double buildStart = omp_get_wtime();
+    RTree* rtree = new RTree(network);
+    rtree->build();
+    double buildEnd = omp_get_wtime();
+    std::cout << "R-tree nodes: " << rtree->getNumOfNodes() << ", height: " << rtree->getHeight() << std::endl;
+    // Match VDS to links
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    linkOfVDS.assign(numOfVDS, -1);
+
+    double start = omp_get_wtime();
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+    for (int i = 0; i < numOfVDS; i++)
+    {
+        VDS* v = vds->at(i);
+        double distance = -1.0;
+        Link* link = rtree->findNearestLink(v->getLon(), v->getLat(), distance);
+        if (link != nullptr)
+        {
+            linkOfVDS[i] = link->getIndex();
+        }
+    }
+    double end = omp_get_wtime();
+    std::cout << "R-tree build time: " << buildEnd - buildStart << std::endl;
+    std::cout << "Elapsed time: " << end - start << std::endl;
+    if (report != nullptr)
+    {
+        report->addPhase("rtree.build", buildEnd - buildStart);
+        report->addPhase("rtree.match", end - start);
+    }
+
+    delete rtree;
+}
+
+/*! The mean number of links of an occupied cell the automatic cell size aims at */
+const double targetLinksPerCell = 8.0;
+
+double chooseCellSize(Network* network, double maxLengthOfLink, double divideWith, int numThreads, TimingReport* report)
+{
+    double start = omp_get_wtime();
+    double dimension = (divideWith <= 0.0) ? Grid::chooseDimension(network, targetLinksPerCell, numThreads) : maxLengthOfLink / divideWith;
+    if (report != nullptr)
+    {
+        report->addPhase("pic.chooseCellSize", omp_get_wtime() - start);
+    }
+    return dimension;
+}
@@ -0,0 +1,35 @@
+#ifndef MATCHERS_H
+#define MATCHERS_H
+
+#include "DataTypes.h"
+
+class Network;
+class TimingReport;
+
+/*! The matchers that find the nearest link of every VDS of a network. They all return, at the dense
+ *  index of every VDS, the dense index of its nearest link as measured by Link::calcLinkDistanceFromPoint()
+ *  (-1 if the network has no links), with ties going to the link with the smallest ID, so their results
+ *  are identical; they differ only in the index they search.
+ *  @param numThreads the number of OpenMP threads
+ *  @param linkOfVDS set to the link of every VDS
+ *  @param report if not null, the times of the phases of the matcher are added to it
+ */
+
+/*! Exhaustive search: every VDS against every link, with the batched distance kernel of LinkSegments */
+void findLinksOfVDS_Greedy(Network* network, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report = nullptr);
+
+/*! Search of the cells of a Grid of the given cell size around every VDS */
+void findLinksOfVDS_PIC(Network* network, double dimension, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report = nullptr);
+
+/*! Search of an R-tree over the links */
+void findLinksOfVDS_RTree(Network* network, int numThreads, std::vector<int>& linkOfVDS, TimingReport* report = nullptr);
+
+/*!
+ *Function that determines the size of the cells of the PIC grid.
+ *@param divideWith the number by which the maximum link length is divided, 0 (or less) to let the Grid choose the size
+ *@param report if not null, the time of the "pic.chooseCellSize" phase is added to it
+ *@return the size of the cells
+ */
+double chooseCellSize(Network* network, double maxLengthOfLink, double divideWith, int numThreads = 0, TimingReport* report = nullptr);
+
+#endif  //  MATCHERS_H
@@ -0,0 +1,219 @@
+#include <omp.h>
+
+#include "MatchingService.h"
+#include "Network.h"
+#include "RTree.h"
+#include "Link.h"
+#include "Road.h"
+#include "CSVParser.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace
+{
+    /*! The longest request line a client may send; a VDS line is a few dozen bytes */
+    const size_t maxLineLength = 4096;
+}
+
+MatchingService::MatchingService() : network(nullptr), rtree(nullptr), numOfRequests(0), matchingTime(0.0)
+{
+}
+
+MatchingService::MatchingService(Network* _network) : network(_network), rtree(nullptr), numOfRequests(0), matchingTime(0.0)
+{
+}
+
+MatchingService::~MatchingService()
+{
+    if (rtree != nullptr)
+    {
+        delete rtree;
+    }
+}
+
+void MatchingService::start()
+{
+    if (rtree != nullptr)
+    {
+        delete rtree;
+    }
+    rtree = new RTree(network);
+    rtree->build();
+}
+
+std::string MatchingService::answer(const char* line, const char* lineEnd)
+{
+    VDSRecord record;
+    const char* p = line;
+    if (!csv::parseVDSRecord(p, lineEnd, record))
+    {
+        return "error," + std::string(line, lineEnd) + "\n";
+    }
+    double start = omp_get_wtime();
+    double distance = -1.0;
+    Link* link = rtree->findNearestLink(record.lon, record.lat, distance);
+    int roadID = -1;
+    if (link != nullptr && link->getRoadOfLink() != nullptr)
+    {
+        roadID = link->getRoadOfLink()->getID();
+    }
+    double end = omp_get_wtime();
+    {
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        numOfRequests++;
+        matchingTime += end - start;
+    }
+    return std::to_string(record.vdsID) + "," + std::to_string(roadID) + "\n";
+}
+
+void MatchingService::serveStream(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // ignore empty lines and the carriage return of files written on Windows
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+        out << answer(line.data(), line.data() + line.size()) << std::flush;
+    }
+}
+
+void MatchingService::serveClient(int fd)
+{
+    std::vector<char> buffer(1 << 16);
+    // The bytes after the last newline, i.e. the beginning of a request that has not fully arrived
+    std::string pending;
+    ssize_t count = 0;
+    while ((count = ::read(fd, buffer.data(), buffer.size())) > 0)
+    {
+        pending.append(buffer.data(), count);
+        std::string answers;
+        size_t first = 0;
+        size_t newline = 0;
+        while ((newline = pending.find('\n', first)) != std::string::npos)
+        {
+            size_t last = newline;
+            if (last > first && pending[last - 1] == '\r')
+            {
+                last--;
+            }
+            if (last > first)
+            {
+                answers += answer(pending.data() + first, pending.data() + last);
+            }
+            first = newline + 1;
+        }
+        pending.erase(0, first);
+        // A client that never ends its line is dropped, rather than buffered without limit
+        bool tooLong = pending.size() > maxLineLength;
+        if (tooLong)
+        {
+            answers += "error,line too long\n";
+        }
+        // All the answers of one read go out in one write
+        size_t written = 0;
+        while (written < answers.size())
+        {
+            // MSG_NOSIGNAL: a client that has gone away must not kill the service with SIGPIPE
+            ssize_t n = ::send(fd, answers.data() + written, answers.size() - written, MSG_NOSIGNAL);
+            if (n <= 0)
+            {
+                ::close(fd);
+                return;
+            }
+            written += n;
+        }
+        if (tooLong)
+        {
+            break;
+        }
+    }
+    ::close(fd);
+}
+
+bool MatchingService::serveSocket(const std::string& socketPath)
+{
+    struct sockaddr_un address;
+    // A longer path would be truncated, and a different path bound from the one checked below
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    // Only a stale socket is replaced, never a file that happens to have the given name
+    struct stat status;
+    if (::lstat(socketPath.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            std::cerr << "Cannot listen on " << socketPath << ": path exists and is not a socket" << std::endl;
+            return false;
+        }
+        ::unlink(socketPath.c_str());
+    }
+    else if (errno != ENOENT)
+    {
+        std::cerr << "Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        std::cerr << "Cannot create socket" << std::endl;
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    if (::bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 16) != 0)
+    {
+        std::cerr << "Cannot listen on " << socketPath << std::endl;
+        ::close(listener);
+        return false;
+    }
+    std::cerr << "Listening on " << socketPath << std::endl;
+    while (true)
+    {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            // Out of descriptors or memory: wait for clients to leave instead of spinning on accept()
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            {
+                std::cerr << "Cannot accept a client: " << std::strerror(errno) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            std::cerr << "Cannot accept a client: " << std::strerror(errno) << std::endl;
+            ::close(listener);
+            return false;
+        }
+        std::thread(&MatchingService::serveClient, this, fd).detach();
+    }
+}
+
+size_t MatchingService::getNumOfRequests() const
+{
+    return numOfRequests;
+}
+
+double MatchingService::getMeanMatchingTime() const
+{
+    return (numOfRequests > 0) ? matchingTime / static_cast<double>(numOfRequests) : 0.0;
+}
@@ -0,0 +1,72 @@
+#ifndef MATCHINGSERVICE_H
+#define MATCHINGSERVICE_H
+
+#include "DataTypes.h"
+
+#include <mutex>
+
+class Network;
+class RTree;
+
+/*! This class keeps a built Network and an R-tree over its links resident and map-matches VDS records
+ *  as they arrive, one at a time, so that a newly commissioned or relocated detector can be matched
+ *  without rebuilding anything.
+ *
+ *  Every request is one line in the format of the VDS file, "ID,lat,lon", and every answer is one line
+ *  "ID,roadID", as in the VDS_Roads file; roadID is -1 if the nearest link belongs to no road. A line
+ *  that cannot be parsed is answered with "error,<the line>" and empty lines are ignored; a socket client whose
+ *  line grows beyond 4096 bytes is answered with "error,line too long" and disconnected. Answers are
+ *  written in the order of the requests and flushed one by one.
+ *
+ *  Requests are read either from a stream (e.g. stdin) until its end, or from a local Unix socket that
+ *  accepts any number of clients, each served by its own thread; queries only read the index, so the
+ *  clients do not have to synchronise.
+ */
+class MatchingService
+{
+    Network* network;
+    RTree* rtree;
+    /*! Number of requests answered and their total matching time in seconds, over all clients */
+    size_t numOfRequests;
+    double matchingTime;
+    std::mutex statisticsMutex;
+
+    /*! Answers one request line */
+    std::string answer(const char* line, const char* lineEnd);
+    /*! Serves one client of the socket until it disconnects */
+    void serveClient(int fd);
+public:
+    /*! Default constructor */
+    MatchingService();
+    /*! Constructor */
+    MatchingService(Network* _network);
+    /*! Destructor */
+    ~MatchingService();
+    /*! The service owns its index, hence it can be neither copied nor moved */
+    MatchingService(const MatchingService& service) = delete;
+    MatchingService& operator=(const MatchingService& service) = delete;
+
+    /*! Builds the R-tree; it must be called once before serving */
+    void start();
+
+    /*! Answers the requests of a stream until its end
+     *  @param in the requests
+     *  @param out the answers
+     */
+    void serveStream(std::istream& in, std::ostream& out);
+
+    /*! Answers the requests of the clients of a Unix socket; it returns only if the socket cannot be set up
+     *  or accepting clients fails for good
+     *  @param socketPath the path of the socket; an existing socket of that name is replaced, any other file
+     *  is left alone and the service fails
+     *  @return false if the socket cannot be created
+     */
+    bool serveSocket(const std::string& socketPath);
+
+    /*! Setters - Getters */
+    size_t getNumOfRequests() const;
+    /*! The mean time spent matching a request, in seconds */
+    double getMeanMatchingTime() const;
+};
+
+#endif  //  MATCHINGSERVICE_H
@@ -1,28 +1,27 @@
+#include <omp.h>
+
 #include "Network.h"
 #include "Node.h"
 #include "Link.h"
 #include "VDS.h"
 #include "Road.h"
 #include "GeoPos.h"
+#include "MappedFile.h"
+#include "CSVParser.h"
+#include "Profiler.h"
 
-Network::Network() : networkFilename(""), VDSFilename(""), minPos(nullptr), maxPos(nullptr)
+Network::Network() : networkFilename(""), VDSFilename(""), minPos(nullptr), maxPos(nullptr), loaderMode(mappedLoader), numThreads(0)
 {
 }
 
-Network::Network(std::string _networkFilename, std::string _VDSFilename) : networkFilename(_networkFilename), VDSFilename(_VDSFilename), minPos(nullptr), maxPos(nullptr)
+Network::Network(std::string _networkFilename, std::string _VDSFilename) : networkFilename(_networkFilename), VDSFilename(_VDSFilename), minPos(nullptr), maxPos(nullptr), loaderMode(mappedLoader), numThreads(0)
 {
 }
 
 Network::~Network()
 {
-    /*! The Link objects should be deleted before the Node objects because */
-    /*! if the Node objects are deleted first then the Node pointers */
-    /*! (start node and end node pointers) included in the Link objects will */
-    /*! point to deallocated memory until the Links objects are deleted. */
-    /*! This may lead to undefined behavior and hence the Link objects */
-    /*! should be deleted first. */
-    deleteNodes();
-    deleteLinks();
+    /*! Roads and VDS are separate heap objects, whereas the Node and Link objects are views owned by the store. */
+    deleteNodesAndLinks();
     deleteRoads();
     deleteVDS();
     if (minPos != nullptr)
@@ -35,15 +34,9 @@ Network::~Network()
     }
 }
 
-void Network::createNodesAndLinks()
+void Network::readLinkRecordsFromStream(std::vector<LinkRecord>& records)
 {
-    int linkID = -1;
-    int startNodeID = -1;
-    int endNodeID = -1;
-    double startNodeLon = 0.0;
-    double startNodeLat = 0.0;
-    double endNodeLon = 0.0;
-    double endNodeLat = 0.0;
+    LinkRecord record;
     std::string dataline = "";
     bool firstLine = true;
 
@@ -63,147 +56,212 @@ void Network::createNodesAndLinks()
             StringVector items;
             while (std::getline(ss, item, ','))
                 items.push_back(item);
-            linkID = stoi(items[0]);
-
-            /*! start node */
-            startNodeID = stoi(items[1]);
-            startNodeLon = stod(items[2]);
-            startNodeLat = stod(items[3]);
-            
-            Node* startNode;
-            auto it = nodes.find(startNodeID);
-            if (it == nodes.end())
+            if (items.size() < 7)
             {
-                startNode = new Node(startNodeID, startNodeLat, startNodeLon);
-                nodes.insert(std::make_pair(startNodeID, startNode));
-            }
-            else
-            {
-                startNode = it->second;
-            }
-            
-            /*! end node */
-            endNodeID = stoi(items[4]);
-            endNodeLon = stod(items[5]);
-            endNodeLat = stod(items[6]);
-            
-            Node* endNode;
-            it = nodes.find(endNodeID);
-            if (it == nodes.end())
-            {
-                endNode = new Node(endNodeID, endNodeLat, endNodeLon);
-                nodes.insert(std::make_pair(endNodeID, endNode));
-            }
-            else
-            {   
-                endNode = it->second;
+                continue;
             }
-     
+            record.linkID = stoi(items[0]);
+            record.startNodeID = stoi(items[1]);
+            record.startNodeLon = stod(items[2]);
+            record.startNodeLat = stod(items[3]);
+            record.endNodeID = stoi(items[4]);
+            record.endNodeLon = stod(items[5]);
+            record.endNodeLat = stod(items[6]);
             items.clear();
-            
-            /*! Create link */
-            Link* link = new Link(linkID, startNode, endNode);
-            link->computeLength();
-            links.insert(std::make_pair(linkID, link));
-            startNode->addOutgoingLink(linkID, link);
-            endNode->addIncomingLink(linkID, link);
+            records.push_back(record);
         }
         in.close();
     }
 }
 
+namespace
+{
+    /*! Files are not split into ranges smaller than this, the thread start-up would cost more than the parsing */
+    const size_t minChunkSize = 1 << 20;
+
+    /*! Parses the body of a mapped file (i.e. without the header) on several threads.
+     *  Every range gets its own record buffer, so the buffers concatenated in range order
+     *  hold the records in file order, exactly as a sequential reader would see them.
+     */
+    template <typename Record>
+    std::vector< std::vector<Record> > parseRecordsInParallel(const char* begin, const char* end, int numThreads,
+        void (*parseRecords)(const char*, const char*, std::vector<Record>&))
+    {
+        if (numThreads <= 0)
+        {
+            numThreads = omp_get_max_threads();
+        }
+        std::vector< std::pair<const char*, const char*> > chunks = csv::splitLines(begin, end, numThreads, minChunkSize);
+        std::vector< std::vector<Record> > buffers(chunks.size());
+        int numOfChunks = static_cast<int>(chunks.size());
+#pragma omp parallel for num_threads(numThreads) schedule(static, 1) if(numOfChunks > 1)
+        for (int i = 0; i < numOfChunks; i++)
+        {
+            parseRecords(chunks[i].first, chunks[i].second, buffers[i]);
+        }
+        return buffers;
+    }
+}
+
+void Network::readLinkRecordsFromMapping(std::vector<LinkRecord>& records)
+{
+    MappedFile file(networkFilename);
+    if (!file.open())
+    {
+        /*! Not a regular file (e.g. a pipe), read it line by line instead */
+        readLinkRecordsFromStream(records);
+        return;
+    }
+    /*! skip the file header */
+    const char* begin = csv::skipLine(file.getData(), file.getEnd());
+    std::vector< std::vector<LinkRecord> > buffers = parseRecordsInParallel<LinkRecord>(begin, file.getEnd(), numThreads, csv::parseLinkRecords);
+    /*! The buffers are concatenated in range order, so the records are in file order as with the stream loader */
+    size_t numOfRecords = 0;
+    for (const auto& buffer : buffers)
+    {
+        numOfRecords += buffer.size();
+    }
+    records.reserve(records.size() + numOfRecords);
+    for (const auto& buffer : buffers)
+    {
+        records.insert(records.end(), buffer.begin(), buffer.end());
+    }
+}
+
+void Network::createNodesAndLinks()
+{
+    PROFILE_PHASE(phase, "Network::createNodesAndLinks");
+    std::vector<LinkRecord> records;
+    if (loaderMode == mappedLoader)
+    {
+        readLinkRecordsFromMapping(records);
+    }
+    else
+    {
+        readLinkRecordsFromStream(records);
+    }
+    store.build(records, numThreads);
+    createNodeAndLinkMaps();
+    PROFILE_COUNT(phase, "records", records.size());
+    PROFILE_COUNT(phase, "nodes", store.getNumOfNodes());
+    PROFILE_COUNT(phase, "links", store.getNumOfLinks());
+}
+
+void Network::createNodeAndLinkMaps()
+{
+    nodes.clear();
+    links.clear();
+    nodes.reserve(store.getNumOfNodes());
+    links.reserve(store.getNumOfLinks());
+    /*! The store is sorted by ID, so the dense indices of the maps are those of the store */
+    for (size_t n = 0; n < store.getNumOfNodes(); n++)
+    {
+        Node* node = store.getNode(static_cast<int>(n));
+        nodes.insert(node->getID(), node);
+    }
+    for (size_t i = 0; i < store.getNumOfLinks(); i++)
+    {
+        Link* link = store.getLink(static_cast<int>(i));
+        links.insert(link->getID(), link);
+    }
+}
+
+void Network::pairOppositeLinks()
+{
+    PROFILE_PHASE(phase, "Network::pairOppositeLinks");
+    [[maybe_unused]] size_t numOfPairs = store.pairOppositeLinks();
+    PROFILE_COUNT(phase, "links", store.getNumOfLinks());
+    PROFILE_COUNT(phase, "pairs", numOfPairs);
+}
+
 void Network::createBeforeAfterLinks()
 {
-   for (const auto& linkIt : links)
-   {
-       int linkID = linkIt.first;
-
-       // First examine the start node
-       LinkMap* incomingLinks = linkIt.second->getStartNode()->getIncomingLinks();
-       LinkMap* outgoingLinks = linkIt.second->getStartNode()->getOutgoingLinks();
-       
-       // Incoming links of the start node are "before in" links of the link.
-       for (LinkMap::iterator it = incomingLinks->begin(); it != incomingLinks->end(); ++it)
-       {
-           if (it->first != linkID)
-           {
-               linkIt.second->addBeforeInLink(it->first, it->second);
-           }
-       }
-       // Outgoing links of the start node are "before out" links of the link.
-       for (LinkMap::iterator it = outgoingLinks->begin(); it != outgoingLinks->end(); ++it)
-       {
-           if (it->first != linkID)
-           {
-               linkIt.second->addBeforeOutLink(it->first, it->second);
-           }
-       }
-           
-       // Then examine the end node
-       incomingLinks = linkIt.second->getEndNode()->getIncomingLinks();
-       outgoingLinks = linkIt.second->getEndNode()->getOutgoingLinks();
-       
-       // Incoming links of the end node are "after in" links of the link.
-       for (LinkMap::iterator it = incomingLinks->begin(); it != incomingLinks->end(); ++it)
-       {
-           if (it->first != linkID)
-           {
-               linkIt.second->addAfterInLink(it->first, it->second);
-           }
-       }
-       // Outgoing links of the end node are "after out" links of the link.
-       for (LinkMap::iterator it = outgoingLinks->begin(); it != outgoingLinks->end(); ++it)
-       {
-           if (it->first != linkID)
-           {
-               linkIt.second->addAfterOutLink(it->first, it->second);
-           }
-       }
-   }
+    PROFILE_PHASE(phase, "Network::createBeforeAfterLinks");
+    store.createNeighbourhoods(numThreads);
+    PROFILE_COUNT(phase, "links", store.getNumOfLinks());
+}
+
+void Network::classifyNodes()
+{
+    PROFILE_PHASE(phase, "Network::classifyNodes");
+    store.classifyNodes(numThreads);
+    PROFILE_COUNT(phase, "nodes", store.getNumOfNodes());
 }
 
 void Network::createRoads()
 {
-    for (auto it = nodes.begin(); it != nodes.end(); ++it)
+    PROFILE_PHASE(phase, "Network::createRoads");
+    int numOfNodes = static_cast<int>(nodes.size());
+    int threads = (numThreads > 0) ? numThreads : omp_get_max_threads();
+    /*! The walks follow the departure links of the classification */
+    if (!store.isClassified())
     {
-        Node* startNode = it->second;
-        if (!(startNode->isIntermediate()))
+        store.classifyNodes(numThreads);
+    }
+
+    /*! Every outgoing link of a node that is not intermediate is the head of a chain, i.e. of a road. A chain only
+     *  continues through intermediate nodes, and every link leaving an intermediate node is reached from exactly one
+     *  arriving link, so the chains are disjoint and each of them can be walked on its own. The roads are numbered
+     *  in node ID order and then in the order of the outgoing links, as a sequential walk over the nodes numbers them;
+     *  firstRoadOfNode[n] is the number of roads before node n, found by a prefix sum of the heads per node. */
+    std::vector<int> firstRoadOfNode(numOfNodes + 1, 0);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 4096)
+    for (int n = 0; n < numOfNodes; n++)
+    {
+        NodeKind kind = store.getNodeKind(n);
+        bool intermediate = (kind == oneWayPassThroughNode || kind == twoWayPassThroughNode);
+        firstRoadOfNode[n + 1] = intermediate ? 0 : static_cast<int>(store.getOutgoingLinks(n).size());
+    }
+    std::partial_sum(firstRoadOfNode.begin(), firstRoadOfNode.end(), firstRoadOfNode.begin());
+
+    /*! The roads are interned in ID order first, the walks only fill them in */
+    int firstRoadID = static_cast<int>(roads.size());
+    int numOfNewRoads = firstRoadOfNode[numOfNodes];
+    std::vector<Road*> newRoads(numOfNewRoads);
+    roads.reserve(roads.size() + numOfNewRoads);
+    for (int r = 0; r < numOfNewRoads; r++)
+    {
+        newRoads[r] = addRoad(firstRoadID + r);
+    }
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1024)
+    for (int n = 0; n < numOfNodes; n++)
+    {
+        if (firstRoadOfNode[n + 1] == firstRoadOfNode[n])
+        {
+            continue;
+        }
+        Node* startNode = nodes.at(n);
+        Road** road = newRoads.data() + firstRoadOfNode[n];
+        LinkRange outgoingLinks = startNode->getOutgoingLinks();
+        for (Link* startLink : outgoingLinks)
         {
-            LinkMap* outgoingLinks = startNode->getOutgoingLinks();;
-            for (auto it = outgoingLinks->begin(); it != outgoingLinks->end(); ++it)
+            (*road)->setStartNode(startNode);
+            (*road)->addLink(startLink);
+            startLink->setRoadOfLink(*road);
+
+            int link = startLink->getIndex();
+            int endLink = store.getDepartureLink(link);
+            while (endLink != -1)
             {
-                Link* startLink = it->second;
-                if (startLink->getRoadOfLink() == nullptr)
-                {
-                    int roadID = static_cast<int>(roads.size());
-                    Road* road = addRoad(roadID);;
-                    road->setStartNode(startNode);
-                    road->addLink(startLink->getID(), startLink);
-                    startLink->setRoadOfLink(road);
-
-                    Node* endNode = startLink->getEndNode();
-                    Link* endLink = endNode->isIntermediateGetDepar(startLink);
-                    while (endLink != nullptr /*&& !eLink->IsLoop()*/)
-                    {
-                        road->addLink(endLink->getID(), endLink);
-                        endLink->setRoadOfLink(road);
-                        endNode = endLink->getEndNode();
-                        endLink = endNode->isIntermediateGetDepar(endLink);
-                    }
-                    road->setEndNode(endNode);
-                    road->computeLength();
-                }
-            } 
+                Link* next = store.getLink(endLink);
+                (*road)->addLink(next);
+                next->setRoadOfLink(*road);
+                link = endLink;
+                endLink = store.getDepartureLink(link);
+            }
+            (*road)->setEndNode(store.getNode(store.getLinkEndNode(link)));
+            (*road)->computeLength();
+            road++;
         }
     }
+    PROFILE_COUNT(phase, "roads", roads.size());
 }
 
-void Network::createVDS()
+void Network::readVDSRecordsFromStream(std::vector<VDSRecord>& records)
 {
     /*! Load loop detectors coordinates file */
-    int vdsID = -1;
-    double lat = 0.0;
-    double lon = 0.0;
+    VDSRecord record;
     std::string dataline = "";
     bool firstLine = true;
     std::ifstream in(VDSFilename);
@@ -223,29 +281,99 @@ void Network::createVDS()
             StringVector items;
             while(std::getline(ss, item, ','))  // .csv file so the separator is ","
                 items.push_back(item);
-            vdsID = stoi(items[0]);
-            lat = stod(items[1]);
-            lon = stod(items[2]);
-            items.clear();
-            auto it = vds.find(vdsID);
-            if (it == vds.end())
+            if (items.size() < 3)
             {
-                VDS* pVDS = new VDS(vdsID, lat, lon);
-                vds.insert(std::make_pair(vdsID, pVDS));
+                continue;
             }
+            record.vdsID = stoi(items[0]);
+            record.lat = stod(items[1]);
+            record.lon = stod(items[2]);
+            items.clear();
+            records.push_back(record);
         }
         in.close();
     }
 }
 
+void Network::readVDSRecordsFromMapping(std::vector<VDSRecord>& records)
+{
+    MappedFile file(VDSFilename);
+    if (!file.open())
+    {
+        readVDSRecordsFromStream(records);
+        return;
+    }
+    // to skip file header
+    const char* begin = csv::skipLine(file.getData(), file.getEnd());
+    std::vector< std::vector<VDSRecord> > buffers = parseRecordsInParallel<VDSRecord>(begin, file.getEnd(), numThreads, csv::parseVDSRecords);
+    for (const auto& buffer : buffers)
+    {
+        records.insert(records.end(), buffer.begin(), buffer.end());
+    }
+}
+
+void Network::createVDS()
+{
+    PROFILE_PHASE(phase, "Network::createVDS");
+    std::vector<VDSRecord> records;
+    if (loaderMode == mappedLoader)
+    {
+        readVDSRecordsFromMapping(records);
+    }
+    else
+    {
+        readVDSRecordsFromStream(records);
+    }
+    /*! The VDS are interned in ID order; if an ID appears more than once, its first line is kept */
+    std::stable_sort(records.begin(), records.end(), [](const VDSRecord& a, const VDSRecord& b) { return a.vdsID < b.vdsID; });
+    vds.reserve(records.size());
+    for (const auto& record : records)
+    {
+        if (vds.indexOf(record.vdsID) == -1)
+        {
+            vds.insert(record.vdsID, new VDS(record.vdsID, record.lat, record.lon));
+        }
+    }
+    PROFILE_COUNT(phase, "records", records.size());
+    PROFILE_COUNT(phase, "VDS", vds.size());
+}
+
 void Network::build()
 {
+    PROFILE_PHASE(phase, "Network::build");
     createNodesAndLinks();
+    pairOppositeLinks();
     createBeforeAfterLinks();
+    classifyNodes();
     createRoads();
     createVDS();
 }
 
+GraphStore* Network::getGraphStore()
+{
+    return &store;
+}
+
+void Network::setLoaderMode(const LoaderMode _loaderMode)
+{
+    loaderMode = _loaderMode;
+}
+
+LoaderMode Network::getLoaderMode() const
+{
+    return loaderMode;
+}
+
+void Network::setNumThreads(const int _numThreads)
+{
+    numThreads = _numThreads;
+}
+
+int Network::getNumThreads() const
+{
+    return numThreads;
+}
+
 size_t Network::getNumOfNodes() const
 {
     return nodes.size();
@@ -258,14 +386,7 @@ NodeMap* Network::getNodes()
 
 Node* Network::getNode(const int nodeID)
 {
-    if (nodes.find(nodeID) != nodes.end())
-    {
-        return nodes[nodeID];
-    }
-    else
-    {
-        return nullptr;
-    }
+    return nodes.get(nodeID);
 }
 
 size_t Network::getNumOfLinks() const
@@ -280,14 +401,7 @@ LinkMap* Network::getLinks()
 
 Link* Network::getLink(const int linkID) 
 {
-    if (links.find(linkID) != links.end())
-    {
-        return links[linkID];
-    }
-    else
-    {
-        return nullptr;
-    }
+    return links.get(linkID);
 }
 
 size_t Network::getNumOfVDS() const
@@ -302,14 +416,7 @@ VDSMap* Network::getVDS()
 
 VDS* Network::getVDS(const int vdsID)
 {
-    if (vds.find(vdsID) != vds.end())
-    {
-        return vds[vdsID];
-    }
-    else
-    {
-        return nullptr;
-    }
+    return vds.get(vdsID);
 }
 
 size_t Network::getNumOfRoads() const
@@ -324,14 +431,7 @@ RoadMap* Network::getRoads()
 
 Road* Network::getRoad(const int roadID)
 {
-    if (roads.find(roadID) != roads.end())
-    {
-        return roads[roadID];
-    }
-    else
-    {
-        return nullptr;
-    }
+    return roads.get(roadID);
 }
 
 void Network::setPosLimits()
@@ -342,9 +442,8 @@ void Network::setPosLimits()
     for (const auto& n : nodes)
     {
         Node* node = n.second;
-        GeoPos* pos = node->getGeoPos();
-        double lat = pos->getLat();
-        double lon = pos->getLon();
+        double lat = node->getLat();
+        double lon = node->getLon();
         if (lat < minLat)
         {
             minLat = lat;
@@ -453,32 +552,20 @@ void Network::findMinMaxMeanLengthOfRoads(double& minLength, double& maxLength,
 Road* Network::addRoad(const int roadID)
 {
     Road* road = new Road(roadID);
-    roads[roadID] = road;
-    return road;
-}
-
-void Network::deleteNodes()
-{
-    if (!nodes.empty())
+    if (roads.insert(roadID, road) == -1)
     {
-        for (const auto& node : nodes)
-        {
-            delete node.second;
-        }
-        nodes.clear();
+        /*! Road IDs are handed out in ascending order, an existing ID is never added twice */
+        delete road;
+        return roads.get(roadID);
     }
+    return road;
 }
 
-void Network::deleteLinks()
+void Network::deleteNodesAndLinks()
 {
-    if (!links.empty())
-    {
-        for (const auto& link : links)
-        {
-            delete link.second;
-        }
-        links.clear();
-    }
+    nodes.clear();
+    links.clear();
+    store.clear();
 }
 
 void Network::deleteRoads()
@@ -2,23 +2,38 @@
 #define NETWORK_H
 
 #include "DataTypes.h"
+#include "GraphStore.h"
 
 class GeoPos;
 class Node;
 class Link;
 class Road;
 class VDS;
+struct LinkRecord;
+struct VDSRecord;
 
 class Network
 {			
     std::string networkFilename;
     std::string VDSFilename;
+    /*! The nodes and links of the network in structure-of-arrays form; the maps below refer to its views */
+    GraphStore store;
     NodeMap nodes;
     LinkMap links;
     RoadMap roads;
     VDSMap vds;
     GeoPos* minPos;
     GeoPos* maxPos;
+    LoaderMode loaderMode;
+    /*! Number of OpenMP threads used while building the network, 0 means the OpenMP default */
+    int numThreads;
+
+    /*! Read the lines of the network file, in file order */
+    void readLinkRecordsFromStream(std::vector<LinkRecord>& records);
+    void readLinkRecordsFromMapping(std::vector<LinkRecord>& records);
+    /*! Read the lines of the VDS file, in file order */
+    void readVDSRecordsFromStream(std::vector<VDSRecord>& records);
+    void readVDSRecordsFromMapping(std::vector<VDSRecord>& records);
 
 public:
     /*! Default constructor */
@@ -30,12 +45,24 @@ public:
     
     /*! Routines for constructing the topology of the network */
     void createNodesAndLinks();
+    /*! Links the two directions of every two-way segment, see GraphStore::pairOppositeLinks() */
+    void pairOppositeLinks();
     void createBeforeAfterLinks();
+    /*! Classifies the nodes of the store, see GraphStore::classifyNodes() */
+    void classifyNodes();
     void createRoads();
     void createVDS();
     void build();
 
+    /*! Fills the node and link maps with the views of the store, after the store has been built */
+    void createNodeAndLinkMaps();
+
     /*! Setters - Getters */
+    GraphStore* getGraphStore();
+    void setLoaderMode(const LoaderMode _loaderMode);
+    LoaderMode getLoaderMode() const;
+    void setNumThreads(const int _numThreads);
+    int getNumThreads() const;
     size_t getNumOfNodes() const;
     NodeMap* getNodes();
     
@@ -73,9 +100,8 @@ public:
 
     Road* addRoad(const int roadID);
 
-    /*! Deletes the Link objects of the network. */
-    void deleteNodes();
-    void deleteLinks();
+    /*! Deletes the nodes and links of the network, i.e. clears the store. */
+    void deleteNodesAndLinks();
     void deleteRoads();
     void deleteVDS();
 };
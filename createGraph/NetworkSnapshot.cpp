@@ -0,0 +1,526 @@
+#include "NetworkSnapshot.h"
+#include "Network.h"
+#include "GraphStore.h"
+#include "Node.h"
+#include "Link.h"
+#include "Road.h"
+#include "VDS.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <sys/stat.h>
+
+/*! Version 3: the links are paired with their opposites and the roads run through two-way nodes, so an older snapshot holds other roads.
+ *  Version 4: the source files are recorded in the file. */
+const uint32_t NetworkSnapshot::version = 4;
+
+namespace
+{
+    const char magic[8] = {'C', 'G', 'S', 'N', 'A', 'P', '\0', '\0'};
+    const uint32_t byteOrderMark = 0x01020304;
+
+    /*! The four neighbour lists of a link (before-in, before-out, after-in, after-out), in the order they are stored */
+    const int numOfNeighbourLists = GraphStore::numOfNeighbourLists;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t byteOrderMark;
+        uint32_t version;
+        uint64_t numOfSources;
+        uint64_t numOfSourcePathBytes;
+        uint64_t numOfNodes;
+        uint64_t numOfLinks;
+        uint64_t numOfNeighbours;
+        uint64_t numOfRoads;
+        uint64_t numOfRoadLinks;
+        uint64_t numOfVDS;
+    };
+
+    /*! A file the network has been built from: the snapshot is stale as soon as one of these changes. The
+     *  canonical paths of the sources follow the entries, one after the other. */
+    struct SourceEntry
+    {
+        uint64_t size;
+        int64_t mtimeSeconds;
+        int64_t mtimeNanoseconds;
+        uint64_t pathLength;
+    };
+
+    /*! Describes the source files as they are now
+     *  @return false if one of them cannot be found
+     */
+    bool describeSources(const StringVector& sourceFilenames, std::vector<SourceEntry>& entries, std::vector<char>& paths)
+    {
+        entries.clear();
+        paths.clear();
+        for (const auto& sourceFilename : sourceFilenames)
+        {
+            char path[PATH_MAX];
+            struct stat sourceStat;
+            if (realpath(sourceFilename.c_str(), path) == nullptr || stat(path, &sourceStat) != 0)
+            {
+                return false;
+            }
+            size_t pathLength = std::strlen(path);
+            entries.push_back(SourceEntry{static_cast<uint64_t>(sourceStat.st_size), static_cast<int64_t>(sourceStat.st_mtim.tv_sec),
+                static_cast<int64_t>(sourceStat.st_mtim.tv_nsec), pathLength});
+            paths.insert(paths.end(), path, path + pathLength);
+        }
+        return true;
+    }
+
+    struct NodeEntry
+    {
+        int32_t ID;
+        int32_t padding;
+        double lat;
+        double lon;
+    };
+
+    /*! Nodes, roads and opposite links are referenced by their position in the file, -1 meaning none */
+    struct LinkEntry
+    {
+        int32_t ID;
+        int32_t startNode;
+        int32_t endNode;
+        int32_t road;
+        int32_t oppositeLink;
+        int32_t direction;
+        double length;
+    };
+
+    struct RoadEntry
+    {
+        int32_t ID;
+        int32_t startNode;
+        int32_t endNode;
+        int32_t padding;
+        double length;
+    };
+
+    struct VDSEntry
+    {
+        int32_t ID;
+        int32_t padding;
+        double lat;
+        double lon;
+    };
+
+    /*! Every section starts at a multiple of 8 bytes, so that it can be read in place from the mapping */
+    size_t paddedSize(size_t size)
+    {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    template <typename T>
+    void writeSection(std::ofstream& out, const std::vector<T>& section)
+    {
+        size_t size = section.size() * sizeof(T);
+        if (size > 0)
+        {
+            out.write(reinterpret_cast<const char*>(section.data()), size);
+        }
+        const char zeros[8] = {0};
+        out.write(zeros, paddedSize(size) - size);
+    }
+
+    /*! Returns the section of count elements of type T at p and moves p past it, or nullptr if the file is too short */
+    template <typename T>
+    const T* readSection(const char*& p, const char* end, uint64_t count)
+    {
+        if (count > static_cast<uint64_t>(end - p) / sizeof(T))
+        {
+            return nullptr;
+        }
+        size_t size = paddedSize(count * sizeof(T));
+        if (static_cast<size_t>(end - p) < size)
+        {
+            return nullptr;
+        }
+        const T* section = reinterpret_cast<const T*>(p);
+        p += size;
+        return section;
+    }
+
+    bool isIndex(int32_t index, uint64_t count)
+    {
+        return index >= 0 && static_cast<uint64_t>(index) < count;
+    }
+
+    /*! The dense indices and the CSR offsets of the store are ints, so every count must fit in one */
+    bool isCount(uint64_t count)
+    {
+        return count <= static_cast<uint64_t>(std::numeric_limits<int32_t>::max());
+    }
+}
+
+NetworkSnapshot::NetworkSnapshot() : filename("")
+{
+}
+
+NetworkSnapshot::NetworkSnapshot(std::string _filename) : filename(_filename)
+{
+}
+
+NetworkSnapshot::~NetworkSnapshot()
+{
+}
+
+void NetworkSnapshot::setFilename(const std::string& _filename)
+{
+    filename = _filename;
+}
+
+std::string NetworkSnapshot::getFilename() const
+{
+    return filename;
+}
+
+bool NetworkSnapshot::write(Network* network, const StringVector& sourceFilenames) const
+{
+    std::vector<SourceEntry> sourceEntries;
+    std::vector<char> sourcePaths;
+    if (!describeSources(sourceFilenames, sourceEntries, sourcePaths))
+    {
+        return false;
+    }
+
+    NodeMap* nodes = network->getNodes();
+    LinkMap* links = network->getLinks();
+    RoadMap* roads = network->getRoads();
+    VDSMap* vds = network->getVDS();
+
+    /*! Nodes and links are written in store order, so their position in the file is their dense index */
+    std::unordered_map<const Road*, int32_t> roadIndex;
+    roadIndex.reserve(roads->size());
+    for (const auto& road : *roads)
+    {
+        roadIndex.insert(std::make_pair(road.second, static_cast<int32_t>(roadIndex.size())));
+    }
+    auto indexOf = [](const auto* element) -> int32_t
+    {
+        return (element != nullptr) ? element->getIndex() : -1;
+    };
+    auto roadIndexOf = [&roadIndex](const Road* road) -> int32_t
+    {
+        auto it = roadIndex.find(road);
+        return (it != roadIndex.end()) ? it->second : -1;
+    };
+
+    std::vector<NodeEntry> nodeEntries;
+    nodeEntries.reserve(nodes->size());
+    for (const auto& node : *nodes)
+    {
+        nodeEntries.push_back(NodeEntry{node.first, 0, node.second->getLat(), node.second->getLon()});
+    }
+
+    std::vector<LinkEntry> linkEntries;
+    std::vector<uint64_t> neighbourOffsets;
+    std::vector<int32_t> neighbours;
+    linkEntries.reserve(links->size());
+    neighbourOffsets.reserve(numOfNeighbourLists * links->size() + 1);
+    GraphStore* store = network->getGraphStore();
+    for (const auto& linkIt : *links)
+    {
+        Link* link = linkIt.second;
+        linkEntries.push_back(LinkEntry{linkIt.first, indexOf(link->getStartNode()), indexOf(link->getEndNode()),
+            roadIndexOf(link->getRoadOfLink()), indexOf(link->getOppositeLink()),
+            static_cast<int32_t>(link->getDirection()), link->getLength()});
+        for (int list = 0; list < numOfNeighbourLists; list++)
+        {
+            neighbourOffsets.push_back(neighbours.size());
+            for (Link* neighbour : store->getNeighbourLinks(link->getIndex(), list))
+            {
+                neighbours.push_back(indexOf(neighbour));
+            }
+        }
+    }
+    neighbourOffsets.push_back(neighbours.size());
+
+    std::vector<RoadEntry> roadEntries;
+    std::vector<uint64_t> roadLinkOffsets;
+    std::vector<int32_t> roadLinks;
+    roadEntries.reserve(roads->size());
+    roadLinkOffsets.reserve(roads->size() + 1);
+    for (const auto& roadIt : *roads)
+    {
+        Road* road = roadIt.second;
+        roadEntries.push_back(RoadEntry{roadIt.first, indexOf(road->getStartNode()), indexOf(road->getEndNode()), 0, road->getLength()});
+        roadLinkOffsets.push_back(roadLinks.size());
+        for (Link* link : *road->getLinks())
+        {
+            roadLinks.push_back(indexOf(link));
+        }
+    }
+    roadLinkOffsets.push_back(roadLinks.size());
+
+    std::vector<VDSEntry> vdsEntries;
+    vdsEntries.reserve(vds->size());
+    for (const auto& v : *vds)
+    {
+        vdsEntries.push_back(VDSEntry{v.first, 0, v.second->getLat(), v.second->getLon()});
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.byteOrderMark = byteOrderMark;
+    header.version = version;
+    header.numOfSources = sourceEntries.size();
+    header.numOfSourcePathBytes = sourcePaths.size();
+    header.numOfNodes = nodeEntries.size();
+    header.numOfLinks = linkEntries.size();
+    header.numOfNeighbours = neighbours.size();
+    header.numOfRoads = roadEntries.size();
+    header.numOfRoadLinks = roadLinks.size();
+    header.numOfVDS = vdsEntries.size();
+
+    /*! Write into a temporary file first, so that a reader never sees a half-written snapshot */
+    std::string tempFilename = filename + ".tmp";
+    std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSection(out, sourceEntries);
+    writeSection(out, sourcePaths);
+    writeSection(out, nodeEntries);
+    writeSection(out, linkEntries);
+    writeSection(out, neighbourOffsets);
+    writeSection(out, neighbours);
+    writeSection(out, roadEntries);
+    writeSection(out, roadLinkOffsets);
+    writeSection(out, roadLinks);
+    writeSection(out, vdsEntries);
+    out.close();
+    if (!out)
+    {
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+    return std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+}
+
+bool NetworkSnapshot::read(Network* network) const
+{
+    MappedFile file(filename);
+    if (!file.open() || file.getSize() < sizeof(Header))
+    {
+        return false;
+    }
+    const char* p = file.getData();
+    const char* end = file.getEnd();
+    Header header;
+    std::memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.byteOrderMark != byteOrderMark || header.version != version)
+    {
+        return false;
+    }
+
+    /*! Bounded before numOfLinks and numOfRoads are used in the sizes of the offset sections, which could wrap otherwise */
+    if (!isCount(header.numOfNodes) || !isCount(header.numOfLinks) || !isCount(header.numOfNeighbours) || !isCount(header.numOfRoads)
+        || !isCount(header.numOfRoadLinks) || !isCount(header.numOfVDS))
+    {
+        return false;
+    }
+
+    // The sources are only checked by isUpToDate()
+    if (readSection<SourceEntry>(p, end, header.numOfSources) == nullptr || readSection<char>(p, end, header.numOfSourcePathBytes) == nullptr)
+    {
+        return false;
+    }
+    /*! A failed section does not advance p, so every section is checked: the next one would be read from the wrong place */
+    const NodeEntry* nodeEntries = readSection<NodeEntry>(p, end, header.numOfNodes);
+    const LinkEntry* linkEntries = (nodeEntries != nullptr) ? readSection<LinkEntry>(p, end, header.numOfLinks) : nullptr;
+    const uint64_t* neighbourOffsets = (linkEntries != nullptr) ? readSection<uint64_t>(p, end, numOfNeighbourLists * header.numOfLinks + 1) : nullptr;
+    const int32_t* neighbours = (neighbourOffsets != nullptr) ? readSection<int32_t>(p, end, header.numOfNeighbours) : nullptr;
+    const RoadEntry* roadEntries = (neighbours != nullptr) ? readSection<RoadEntry>(p, end, header.numOfRoads) : nullptr;
+    const uint64_t* roadLinkOffsets = (roadEntries != nullptr) ? readSection<uint64_t>(p, end, header.numOfRoads + 1) : nullptr;
+    const int32_t* roadLinks = (roadLinkOffsets != nullptr) ? readSection<int32_t>(p, end, header.numOfRoadLinks) : nullptr;
+    const VDSEntry* vdsEntries = (roadLinks != nullptr) ? readSection<VDSEntry>(p, end, header.numOfVDS) : nullptr;
+    if (vdsEntries == nullptr || p != end)
+    {
+        return false;
+    }
+
+    /*! Check every reference before creating anything, so that a corrupt file cannot leave a half-built network */
+    for (uint64_t i = 1; i < header.numOfNodes; i++)
+    {
+        if (nodeEntries[i - 1].ID >= nodeEntries[i].ID)
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 1; i < header.numOfLinks; i++)
+    {
+        if (linkEntries[i - 1].ID >= linkEntries[i].ID)
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 1; i < header.numOfRoads; i++)
+    {
+        if (roadEntries[i - 1].ID >= roadEntries[i].ID)
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 1; i < header.numOfVDS; i++)
+    {
+        if (vdsEntries[i - 1].ID >= vdsEntries[i].ID)
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header.numOfLinks; i++)
+    {
+        const LinkEntry& entry = linkEntries[i];
+        if (!isIndex(entry.startNode, header.numOfNodes) || !isIndex(entry.endNode, header.numOfNodes)
+            || (entry.direction != oneway && entry.direction != bidirectional)
+            || (entry.road != -1 && !isIndex(entry.road, header.numOfRoads))
+            || (entry.oppositeLink != -1 && !isIndex(entry.oppositeLink, header.numOfLinks)))
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < numOfNeighbourLists * header.numOfLinks; i++)
+    {
+        if (neighbourOffsets[i] > neighbourOffsets[i + 1])
+        {
+            return false;
+        }
+    }
+    if (neighbourOffsets[numOfNeighbourLists * header.numOfLinks] != header.numOfNeighbours)
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < header.numOfNeighbours; i++)
+    {
+        if (!isIndex(neighbours[i], header.numOfLinks))
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header.numOfRoads; i++)
+    {
+        const RoadEntry& entry = roadEntries[i];
+        if (!isIndex(entry.startNode, header.numOfNodes) || !isIndex(entry.endNode, header.numOfNodes) || roadLinkOffsets[i] > roadLinkOffsets[i + 1])
+        {
+            return false;
+        }
+    }
+    if (roadLinkOffsets[header.numOfRoads] != header.numOfRoadLinks)
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < header.numOfRoadLinks; i++)
+    {
+        if (!isIndex(roadLinks[i], header.numOfLinks))
+        {
+            return false;
+        }
+    }
+
+    /*! The node and link sections are in ascending ID order, i.e. in the order of the dense indices of the store */
+    GraphStore* store = network->getGraphStore();
+    store->clear();
+    store->reserve(header.numOfNodes, header.numOfLinks);
+    for (uint64_t i = 0; i < header.numOfNodes; i++)
+    {
+        const NodeEntry& entry = nodeEntries[i];
+        store->addNode(entry.ID, entry.lat, entry.lon);
+    }
+    for (uint64_t i = 0; i < header.numOfLinks; i++)
+    {
+        const LinkEntry& entry = linkEntries[i];
+        store->addLink(entry.ID, entry.startNode, entry.endNode, entry.length);
+    }
+    store->finalize();
+    network->createNodeAndLinkMaps();
+
+    /*! The roads and VDS are sorted by ID too, so they get the same dense indices as in the written network */
+    RoadMap* roads = network->getRoads();
+    std::vector<Road*> roadByIndex(header.numOfRoads);
+    for (uint64_t i = 0; i < header.numOfRoads; i++)
+    {
+        const RoadEntry& entry = roadEntries[i];
+        Road* road = new Road(entry.ID);
+        road->setStartNode(store->getNode(entry.startNode));
+        road->setEndNode(store->getNode(entry.endNode));
+        road->setLength(entry.length);
+        roadByIndex[i] = road;
+        roads->insert(entry.ID, road);
+        for (uint64_t j = roadLinkOffsets[i]; j < roadLinkOffsets[i + 1]; j++)
+        {
+            Link* link = store->getLink(roadLinks[j]);
+            road->addLink(link);
+        }
+    }
+
+    for (uint64_t i = 0; i < header.numOfLinks; i++)
+    {
+        const LinkEntry& entry = linkEntries[i];
+        int index = static_cast<int>(i);
+        store->setLinkDirection(index, static_cast<Direction>(entry.direction));
+        store->setOppositeLink(index, entry.oppositeLink);
+        store->setLinkRoad(index, (entry.road != -1) ? roadByIndex[entry.road] : nullptr);
+    }
+    store->setNeighbourhoods(std::vector<int>(neighbourOffsets, neighbourOffsets + numOfNeighbourLists * header.numOfLinks + 1),
+        std::vector<int>(neighbours, neighbours + header.numOfNeighbours));
+    /*! The classification is derived from the incidence and the opposite links, so it is not part of the snapshot */
+    store->classifyNodes(network->getNumThreads());
+
+    VDSMap* vds = network->getVDS();
+    for (uint64_t i = 0; i < header.numOfVDS; i++)
+    {
+        const VDSEntry& entry = vdsEntries[i];
+        vds->insert(entry.ID, new VDS(entry.ID, entry.lat, entry.lon));
+    }
+    return true;
+}
+
+bool NetworkSnapshot::isUpToDate(const StringVector& sourceFilenames) const
+{
+    std::vector<SourceEntry> sourceEntries;
+    std::vector<char> sourcePaths;
+    if (!describeSources(sourceFilenames, sourceEntries, sourcePaths))
+    {
+        return false;
+    }
+    MappedFile file(filename);
+    if (!file.open() || file.getSize() < sizeof(Header))
+    {
+        return false;
+    }
+    const char* p = file.getData();
+    const char* end = file.getEnd();
+    Header header;
+    std::memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.byteOrderMark != byteOrderMark || header.version != version
+        || header.numOfSources != sourceEntries.size() || header.numOfSourcePathBytes != sourcePaths.size())
+    {
+        return false;
+    }
+    const SourceEntry* storedEntries = readSection<SourceEntry>(p, end, header.numOfSources);
+    const char* storedPaths = readSection<char>(p, end, header.numOfSourcePathBytes);
+    if (storedEntries == nullptr || storedPaths == nullptr)
+    {
+        return false;
+    }
+    // The same files, in the same order, with the same sizes and modification times
+    for (size_t i = 0; i < sourceEntries.size(); i++)
+    {
+        const SourceEntry& stored = storedEntries[i];
+        const SourceEntry& current = sourceEntries[i];
+        if (stored.size != current.size || stored.mtimeSeconds != current.mtimeSeconds || stored.mtimeNanoseconds != current.mtimeNanoseconds
+            || stored.pathLength != current.pathLength)
+        {
+            return false;
+        }
+    }
+    return sourcePaths.empty() || std::memcmp(storedPaths, sourcePaths.data(), sourcePaths.size()) == 0;
+}
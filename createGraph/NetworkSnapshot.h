@@ -0,0 +1,57 @@
+#ifndef NETWORKSNAPSHOT_H
+#define NETWORKSNAPSHOT_H
+
+#include "DataTypes.h"
+
+class Network;
+
+/*! This class stores a fully built Network (nodes, links, before/after links, roads and VDS) in a
+ *  compact binary file and restores it, so that Network::build() does not have to run on every start.
+ *
+ *  The file consists of a fixed header followed by sections of fixed-size records. Elements refer to
+ *  each other by their position in their section, not by ID, so nothing has to be looked up or
+ *  recomputed while reading. All values are stored in the byte order of the machine that wrote the
+ *  file; a byte-order mark in the header rejects files written on a machine of different endianness.
+ */
+class NetworkSnapshot
+{
+    /*! The name of the snapshot file */
+    std::string filename;
+public:
+    /*! The version of the file format, bumped on every incompatible change */
+    static const uint32_t version;
+
+    /*! Default constructor */
+    NetworkSnapshot();
+    /*! Constructor */
+    NetworkSnapshot(std::string _filename);
+    /*! Destructor */
+    ~NetworkSnapshot();
+
+    /*! Setters - Getters */
+    void setFilename(const std::string& _filename);
+    std::string getFilename() const;
+
+    /*! Writes a built network into the snapshot file
+     *  @param network the network, after Network::build()
+     *  @param sourceFilenames the files the network has been built from, recorded with their canonical paths,
+     *  sizes and modification times
+     *  @return true if the whole snapshot has been written
+     */
+    bool write(Network* network, const StringVector& sourceFilenames) const;
+
+    /*! Fills an empty network with the contents of the snapshot file
+     *  @param network a network without nodes, links, roads and VDS
+     *  @return false if the file is missing, truncated, or of another version; the network is left empty then
+     */
+    bool read(Network* network) const;
+
+    /*! Checks whether the snapshot file exists and has been built from exactly the given source files, as
+     *  they are now: the same canonical paths, in the same order, with the same sizes and modification times
+     *  @param sourceFilenames the files the network would be built from
+     *  @return true if the snapshot can be used instead of the sources; false if a source cannot be found
+     */
+    bool isUpToDate(const StringVector& sourceFilenames) const;
+};
+
+#endif  //  NETWORKSNAPSHOT_H
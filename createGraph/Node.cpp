@@ -1,138 +1,115 @@
 #include "Node.h"
 #include "Link.h"
 #include "GeoPos.h"
+#include "GraphStore.h"
 
-Node::Node() : NetworkElement(-1), pos(new GeoPos())
+Node::Node() : NetworkElement(-1), store(nullptr), index(-1)
 {
 }
 
-Node::Node(int ID, double lat, double lon) : NetworkElement(ID), pos(new GeoPos(lat, lon))
+Node::Node(GraphStore* _store, int _index) : NetworkElement(_store->getNodeID(_index)), store(_store), index(_index)
 {
 }
 
-/*! Responsible for freeing the memory for all node, link, road and VDS objects if the Network object. */
-/*! The data structures incomingLinks and outgoing links contain only references to these objects, */
-/*! and they are not responsible for freeing memory.*/
+/*! The data of the node belongs to the GraphStore, so there is nothing to free here. */
 Node::~Node()
 {
-    if (!incomingLinks.empty())
-    {
-        incomingLinks.clear();
-    }
-    if (!outgoingLinks.empty())
-    {
-        outgoingLinks.clear();
-    }
-    /*! Each node object encapsulates a GeoPos object, and therefore it is responsible for freeing it. */
-    if (pos != nullptr)
-    {
-        delete pos;
-    }
 }
 
-Node::Node(const Node& node) : NetworkElement(node.ID), pos(node.pos)
+Node::Node(const Node& node) : NetworkElement(node.ID), store(node.store), index(node.index)
 {
 }
 
 Node& Node::operator=(const Node& node)
 {
     ID = node.ID;
-    pos = node.pos;
+    store = node.store;
+    index = node.index;
     return *this;
 }
 
-void Node::setGeoPos(GeoPos* _pos)
+int Node::getIndex() const
+{
+    return index;
+}
+
+void Node::setGeoPos(const GeoPos& _pos)
 {
-	pos = _pos;
+	store->setNodePos(index, _pos.getLat(), _pos.getLon());
 }
 
-GeoPos* Node::getGeoPos() const
+GeoPos Node::getGeoPos() const
 {
-	return pos;
+	return GeoPos(getLat(), getLon());
 }
 
 double Node::getLat() const
 {
-    return pos->getLat();
+    return store->getNodeLat(index);
 }
 
 double Node::getLon() const
 {
-	return pos->getLon();
+	return store->getNodeLon(index);
 }
 
 size_t Node::getNumOfIncomingLinks() const
 {
-    return incomingLinks.size();
+    return store->getIncomingLinks(index).size();
 }
 
 size_t Node::getNumOfOutgoingLinks() const
 {
-    return outgoingLinks.size();
+    return store->getOutgoingLinks(index).size();
 }
 
 Link* Node::getIncomingLink(const int incomingLinkID) 
 {
-    auto it = incomingLinks.find(incomingLinkID);
-    if (it != incomingLinks.end())
-    {
-        return incomingLinks[incomingLinkID];
-    }
-    else
+    for (Link* link : store->getIncomingLinks(index))
     {
-        return nullptr;
+        if (link->getID() == incomingLinkID)
+        {
+            return link;
+        }
     }
+    return nullptr;
 }
 
 Link* Node::getOutgoingLink(const int outgoingLinkID)
 {
-    auto it = outgoingLinks.find(outgoingLinkID);
-    if (it != outgoingLinks.end())
-    {
-        return outgoingLinks[outgoingLinkID];
-    }
-    else
+    for (Link* link : store->getOutgoingLinks(index))
     {
-        return nullptr;
+        if (link->getID() == outgoingLinkID)
+        {
+            return link;
+        }
     }
+    return nullptr;
 }
 
-LinkMap* Node::getIncomingLinks()
-{
-    return &incomingLinks;
-}
-
-LinkMap* Node::getOutgoingLinks()
+LinkRange Node::getIncomingLinks()
 {
-    return &outgoingLinks;
+    return store->getIncomingLinks(index);
 }
 
-void Node::addIncomingLink(const int incomingLinkID, Link* incomingLink)
+LinkRange Node::getOutgoingLinks()
 {
-    auto it = incomingLinks.find(incomingLinkID);
-    if (it == incomingLinks.end())
-    {
-        incomingLinks.insert(std::make_pair(incomingLinkID, incomingLink));
-    }
+    return store->getOutgoingLinks(index);
 }
 
-void Node::addOutgoingLink(const int outgoingLinkID, Link* outgoingLink)
+bool Node::isIntermediate()
 {
-    auto it = outgoingLinks.find(outgoingLinkID);
-    if (it == outgoingLinks.end())
+    if (store->isClassified())
     {
-        outgoingLinks.insert(std::make_pair(outgoingLinkID, outgoingLink));
+        NodeKind kind = store->getNodeKind(index);
+        return (kind == oneWayPassThroughNode || kind == twoWayPassThroughNode);
     }
-}
-
-bool Node::isIntermediate()
-{
+    LinkRange outgoingLinks = store->getOutgoingLinks(index);
+    LinkRange incomingLinks = store->getIncomingLinks(index);
     bool Intermediate = false;
     if ((outgoingLinks.size() == 1) && (incomingLinks.size() == 1))
     {
-        auto itOutgoing = outgoingLinks.begin();
-        auto itIncoming = incomingLinks.begin();
-        if (!(itOutgoing->second->isOppositeOf(itIncoming->second)))
+        if (!(outgoingLinks[0]->isOppositeOf(incomingLinks[0])))
         {
             Intermediate = true;
         }
@@ -141,12 +118,8 @@ bool Node::isIntermediate()
     {
         if ((outgoingLinks.size() == 2) && (incomingLinks.size() == 2))
         {
-            auto itOutgoing1 = outgoingLinks.begin();
-            auto itOutgoing2 = itOutgoing1++;
-            auto itIncoming1 = incomingLinks.begin();
-            auto itIncoming2 = itIncoming1++;
-            if ((itOutgoing1->second->isOppositeOf(itIncoming1->second) && itOutgoing2->second->isOppositeOf(itIncoming2->second)) 
-                || (itOutgoing1->second->isOppositeOf(itIncoming2->second) && itOutgoing2->second->isOppositeOf(itIncoming1->second)))
+            if ((outgoingLinks[1]->isOppositeOf(incomingLinks[1]) && outgoingLinks[0]->isOppositeOf(incomingLinks[0])) 
+                || (outgoingLinks[1]->isOppositeOf(incomingLinks[0]) && outgoingLinks[0]->isOppositeOf(incomingLinks[1])))
             {
                 Intermediate = true;
             }
@@ -157,37 +130,44 @@ bool Node::isIntermediate()
 
 Link* Node::isIntermediateGetDepar(Link* ArrLink)
 {
+  /*! The classification holds the departure of every link that arrives here */
+  if (store->isClassified() && store->getLinkEndNode(ArrLink->getIndex()) == index)
+  {
+    int departureLink = store->getDepartureLink(ArrLink->getIndex());
+    return (departureLink != -1) ? store->getLink(departureLink) : nullptr;
+  }
+  LinkRange outgoingLinks = store->getOutgoingLinks(index);
+  LinkRange incomingLinks = store->getIncomingLinks(index);
   Link* DepLink = nullptr;
   if ((outgoingLinks.size() == 1) && (incomingLinks.size() == 1))
   {
-    LinkMap::iterator itOutgoing = outgoingLinks.begin();
-    LinkMap::iterator itIncoming = incomingLinks.begin();
-    if (!(itOutgoing->second->isOppositeOf(itIncoming->second)))
-      DepLink = itOutgoing->second;
+    if (!(outgoingLinks[0]->isOppositeOf(incomingLinks[0])))
+      DepLink = outgoingLinks[0];
   }
   else
   {
     if ((outgoingLinks.size() == 2) && (incomingLinks.size() == 2))
     {
-      LinkMap::iterator itOutgoing1 = outgoingLinks.begin();
-      LinkMap::iterator itOutgoing2 = itOutgoing1++;
-      LinkMap::iterator itIncoming1 = incomingLinks.begin();
-      LinkMap::iterator itIncoming2 = itIncoming1++;
-      if ((itOutgoing1->second->isOppositeOf(itIncoming1->second) &&
-        itOutgoing2->second->isOppositeOf(itIncoming2->second))
+      /*! The first link of each pair is the second element of the list and vice versa, as in the original map-based walk */
+      Link* outgoing1 = outgoingLinks[1];
+      Link* outgoing2 = outgoingLinks[0];
+      Link* incoming1 = incomingLinks[1];
+      Link* incoming2 = incomingLinks[0];
+      if ((outgoing1->isOppositeOf(incoming1) &&
+        outgoing2->isOppositeOf(incoming2))
         ||
-        (itOutgoing1->second->isOppositeOf(itIncoming2->second) &&
-        itOutgoing2->second->isOppositeOf(itIncoming1->second)))
+        (outgoing1->isOppositeOf(incoming2) &&
+        outgoing2->isOppositeOf(incoming1)))
       {
-        if ((!itOutgoing1->second->isOppositeOf(ArrLink)))
-          DepLink = itOutgoing1->second;
+        if ((!outgoing1->isOppositeOf(ArrLink)))
+          DepLink = outgoing1;
         else
         {
-          if ((!itOutgoing2->second->isOppositeOf(ArrLink)))
-            DepLink = itOutgoing2->second;
+          if ((!outgoing2->isOppositeOf(ArrLink)))
+            DepLink = outgoing2;
         }
       }
     }
   }
   return DepLink;
-}
\ No newline at end of file
+}
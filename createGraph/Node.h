@@ -6,19 +6,24 @@
 
 class Link;
 class GeoPos;
+class GraphStore;
 
+/*! A node of the network. It is a thin view of one node of the GraphStore:
+ *  its position and its incoming and outgoing links are kept in the arrays of the store.
+ */
 class Node : public NetworkElement
 {
-    GeoPos* pos;	
-    LinkMap incomingLinks;
-    LinkMap outgoingLinks;
+    /*! The store holding the data of the node */
+    GraphStore* store;
+    /*! The dense index of the node in the store */
+    int index;
 
 public:
     /*! Default constructor */
     Node();
     /*! Constructor */
-    Node(int ID, double lat, double lon);
-    /*! Destructor */ 
+    Node(GraphStore* _store, int _index);
+    /*! Destructor */
     ~Node();
     /*! Copy-constructor */
     Node(const Node& node);
@@ -26,22 +31,21 @@ public:
     Node& operator=(const Node& node);
 
     /*! Setters - Getters */
-    void setGeoPos(GeoPos* _pos);
-    GeoPos* getGeoPos() const;
+    int getIndex() const;
+    void setGeoPos(const GeoPos& _pos);
+    GeoPos getGeoPos() const;
     double getLat() const;
     double getLon() const;
     size_t getNumOfIncomingLinks() const;
     size_t getNumOfOutgoingLinks() const;
     Link* getIncomingLink(const int incomingLinkID);
     Link* getOutgoingLink(const int outgoingLinkID);
-    LinkMap* getIncomingLinks();
-    LinkMap* getOutgoingLinks();
+    LinkRange getIncomingLinks();
+    LinkRange getOutgoingLinks();
 
     /*! Other members functions */
-    void addIncomingLink(const int incomingLinkID, Link* incomingLink);
-    void addOutgoingLink(const int outgoingLinkID, Link* outgoingLink); 
-    bool isIntermediate(); 
+    bool isIntermediate();
     Link* isIntermediateGetDepar(Link* ArrLink);
 };
 
-#endif  // NODE_H
\ No newline at end of file
+#endif  // NODE_H
@@ -0,0 +1,68 @@
+#include <omp.h>
+#include <sys/resource.h>
+
+#include "Profiler.h"
+
+std::vector<Profiler::Phase> Profiler::phases;
+int Profiler::depth = 0;
+std::mutex Profiler::phasesMutex;
+
+size_t Profiler::beginPhase(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    phases.push_back(Phase{name, depth, 0.0, 0, {}});
+    depth++;
+    return phases.size() - 1;
+}
+
+void Profiler::endPhase(size_t phase, double seconds, long peakRSSDelta)
+{
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    phases[phase].seconds = seconds;
+    phases[phase].peakRSSDelta = peakRSSDelta;
+    depth--;
+}
+
+void Profiler::setCount(size_t phase, const std::string& name, size_t value)
+{
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    phases[phase].counts.push_back(std::make_pair(name, value));
+}
+
+std::vector<Profiler::Phase> Profiler::getPhases()
+{
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    return phases;
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(phasesMutex);
+    phases.clear();
+    depth = 0;
+}
+
+long Profiler::getPeakRSS()
+{
+    // ru_maxrss is in kilobytes on Linux
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+ScopedPhase::ScopedPhase(const std::string& name) : phase(Profiler::beginPhase(name)), start(omp_get_wtime()), startPeakRSS(Profiler::getPeakRSS())
+{
+}
+
+ScopedPhase::~ScopedPhase()
+{
+    Profiler::endPhase(phase, omp_get_wtime() - start, Profiler::getPeakRSS() - startPeakRSS);
+}
+
+void ScopedPhase::setCount(const std::string& name, size_t value)
+{
+    Profiler::setCount(phase, name, value);
+}
@@ -0,0 +1,88 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "DataTypes.h"
+
+#include <mutex>
+
+/*! This class records the phases of a run (Network::createNodesAndLinks, Grid::assignLinksToGrid, ...):
+ *  the wall-clock time of every phase, how much it raised the peak resident set size of the process,
+ *  and the numbers of elements it produced (nodes, links, cells, ...).
+ *
+ *  A phase is recorded by a ScopedPhase, declared with the PROFILE_PHASE macro at the top of the code it
+ *  measures, and its counts are set with PROFILE_COUNT:
+ *
+ *      PROFILE_PHASE(phase, "Network::createRoads");
+ *      ...
+ *      PROFILE_COUNT(phase, "roads", roads.size());
+ *
+ *  Phases are kept in the order they start, so a nested phase follows the phase that contains it. The
+ *  peak RSS is a high-water mark, so a phase that allocates less than an earlier phase has freed shows
+ *  a delta of 0.
+ *
+ *  Compiled with -DNO_PROFILING the two macros expand to nothing: no clock or getrusage() call is made
+ *  and the expressions given to PROFILE_COUNT are not evaluated. Profiler::getPhases() is then empty.
+ */
+class Profiler
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        /*! The number of phases that contain this one */
+        int depth;
+        double seconds;
+        /*! The increase of the peak resident set size during the phase, in kilobytes */
+        long peakRSSDelta;
+        /*! (name, value) pairs, in the order they are set */
+        std::vector< std::pair<std::string, size_t> > counts;
+    };
+private:
+    static std::vector<Phase> phases;
+    /*! The number of phases that have started and not ended */
+    static int depth;
+    static std::mutex phasesMutex;
+public:
+    /*! Starts a phase
+     *  @return the position of the phase, which identifies it while it runs
+     */
+    static size_t beginPhase(const std::string& name);
+    static void endPhase(size_t phase, double seconds, long peakRSSDelta);
+    static void setCount(size_t phase, const std::string& name, size_t value);
+
+    /*! Setters - Getters */
+    /*! The phases recorded so far, in the order they started */
+    static std::vector<Phase> getPhases();
+    /*! Forgets the phases recorded so far */
+    static void clear();
+    /*! The peak resident set size of the process so far, in kilobytes */
+    static long getPeakRSS();
+};
+
+/*! Records a phase from its construction to its destruction */
+class ScopedPhase
+{
+    size_t phase;
+    double start;
+    long startPeakRSS;
+public:
+    /*! Constructor */
+    ScopedPhase(const std::string& name);
+    /*! Destructor, it ends the phase */
+    ~ScopedPhase();
+    ScopedPhase(const ScopedPhase& scopedPhase) = delete;
+    ScopedPhase& operator=(const ScopedPhase& scopedPhase) = delete;
+
+    /*! Sets a count of the phase, e.g. the number of links it has created */
+    void setCount(const std::string& name, size_t value);
+};
+
+#ifdef NO_PROFILING
+#define PROFILE_PHASE(phase, name)
+#define PROFILE_COUNT(phase, name, value)
+#else
+#define PROFILE_PHASE(phase, name) ScopedPhase phase(name)
+#define PROFILE_COUNT(phase, name, value) phase.setCount(name, value)
+#endif
+
+#endif  //  PROFILER_H
@@ -0,0 +1,233 @@
+#include "RTree.h"
+#include "Network.h"
+#include "GraphStore.h"
+#include "Link.h"
+
+#include <queue>
+
+namespace
+{
+    /*! An element to be packed into the next level of the tree: a link (leaf level) or a node (upper levels) */
+    struct Item
+    {
+        RTree::Box box;
+        int ID;
+    };
+
+    double centerLon(const RTree::Box& box)
+    {
+        return 0.5 * (box.minLon + box.maxLon);
+    }
+
+    double centerLat(const RTree::Box& box)
+    {
+        return 0.5 * (box.minLat + box.maxLat);
+    }
+
+    /*! Sort-Tile-Recursive ordering: the items are sorted by x into vertical slices of slicesize * maxEntries
+     *  items, and every slice is sorted by y, so that consecutive runs of maxEntries items form compact tiles */
+    void sortTileRecursive(std::vector<Item>& items, int maxEntries)
+    {
+        size_t numOfItems = items.size();
+        size_t numOfGroups = (numOfItems + maxEntries - 1) / maxEntries;
+        size_t numOfSlices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(numOfGroups))));
+        size_t sliceSize = numOfSlices * maxEntries;
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+        {
+            double ca = centerLon(a.box);
+            double cb = centerLon(b.box);
+            return (ca < cb) || (ca == cb && a.ID < b.ID);
+        });
+        for (size_t first = 0; first < numOfItems; first += sliceSize)
+        {
+            size_t last = std::min(first + sliceSize, numOfItems);
+            std::sort(items.begin() + first, items.begin() + last, [](const Item& a, const Item& b)
+            {
+                double ca = centerLat(a.box);
+                double cb = centerLat(b.box);
+                return (ca < cb) || (ca == cb && a.ID < b.ID);
+            });
+        }
+    }
+
+    /*! An element of the best-first search queue: a node of the tree or a link, keyed by its distance from the point */
+    struct Candidate
+    {
+        double distance;
+        /*! A node index if isNode, a dense link index otherwise */
+        int ID;
+        bool isNode;
+    };
+
+    /*! Orders the queue so that the top is the smallest distance; at equal distance nodes are expanded
+     *  before links are reported, and links come out by ascending index (i.e. ascending ID) */
+    struct CandidateGreater
+    {
+        bool operator()(const Candidate& a, const Candidate& b) const
+        {
+            if (a.distance != b.distance)
+            {
+                return a.distance > b.distance;
+            }
+            if (a.isNode != b.isNode)
+            {
+                return !a.isNode;
+            }
+            return a.ID > b.ID;
+        }
+    };
+}
+
+RTree::RTree() : network(nullptr), maxEntries(16), numOfLeaves(0), height(0)
+{
+}
+
+RTree::RTree(Network* _network, int _maxEntries) : network(_network), maxEntries(std::max(_maxEntries, 2)), numOfLeaves(0), height(0)
+{
+}
+
+RTree::~RTree()
+{
+}
+
+RTree::Box RTree::getLinkBox(const int link) const
+{
+    GraphStore* store = network->getGraphStore();
+    int startNode = store->getLinkStartNode(link);
+    int endNode = store->getLinkEndNode(link);
+    double startLon = store->getNodeLon(startNode);
+    double startLat = store->getNodeLat(startNode);
+    double endLon = store->getNodeLon(endNode);
+    double endLat = store->getNodeLat(endNode);
+    return Box{std::min(startLon, endLon), std::min(startLat, endLat), std::max(startLon, endLon), std::max(startLat, endLat)};
+}
+
+void RTree::build()
+{
+    boxes.clear();
+    firstEntries.clear();
+    numOfEntries.clear();
+    entries.clear();
+    numOfLeaves = 0;
+    height = 0;
+
+    int numOfLinks = static_cast<int>(network->getGraphStore()->getNumOfLinks());
+    if (numOfLinks == 0)
+    {
+        return;
+    }
+    std::vector<Item> items(numOfLinks);
+    for (int i = 0; i < numOfLinks; i++)
+    {
+        items[i] = Item{getLinkBox(i), i};
+    }
+
+    /*! Pack one level at a time until a single node, the root, is left */
+    bool leafLevel = true;
+    while (leafLevel || items.size() > 1)
+    {
+        sortTileRecursive(items, maxEntries);
+        std::vector<Item> parents;
+        for (size_t first = 0; first < items.size(); first += maxEntries)
+        {
+            size_t last = std::min(first + maxEntries, items.size());
+            Box box = items[first].box;
+            int node = static_cast<int>(boxes.size());
+            firstEntries.push_back(static_cast<int>(entries.size()));
+            numOfEntries.push_back(static_cast<int>(last - first));
+            for (size_t i = first; i < last; i++)
+            {
+                const Box& childBox = items[i].box;
+                box.minLon = std::min(box.minLon, childBox.minLon);
+                box.minLat = std::min(box.minLat, childBox.minLat);
+                box.maxLon = std::max(box.maxLon, childBox.maxLon);
+                box.maxLat = std::max(box.maxLat, childBox.maxLat);
+                entries.push_back(items[i].ID);
+            }
+            boxes.push_back(box);
+            parents.push_back(Item{box, node});
+        }
+        if (leafLevel)
+        {
+            numOfLeaves = static_cast<int>(boxes.size());
+            leafLevel = false;
+        }
+        height++;
+        items.swap(parents);
+    }
+}
+
+double RTree::calcBoxDistanceFromPoint(const Box& box, double lon, double lat)
+{
+    double dx = std::max(std::max(box.minLon - lon, lon - box.maxLon), 0.0);
+    double dy = std::max(std::max(box.minLat - lat, lat - box.maxLat), 0.0);
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+Link* RTree::findNearestLink(double lon, double lat, double& distance) const
+{
+    std::vector<LinkCandidate> candidates;
+    findNearestLinks(lon, lat, 1, std::numeric_limits<double>::infinity(), candidates);
+    if (candidates.empty())
+    {
+        distance = -1.0;
+        return nullptr;
+    }
+    distance = candidates[0].distance;
+    return candidates[0].link;
+}
+
+void RTree::findNearestLinks(double lon, double lat, size_t k, double maxDistance, std::vector<LinkCandidate>& candidates) const
+{
+    candidates.clear();
+    if (boxes.empty() || k == 0)
+    {
+        return;
+    }
+    GraphStore* store = network->getGraphStore();
+    std::vector<Candidate> container;
+    container.reserve(4 * maxEntries * height);
+    std::priority_queue<Candidate, std::vector<Candidate>, CandidateGreater> queue(CandidateGreater(), std::move(container));
+    int root = static_cast<int>(boxes.size()) - 1;
+    double rootDistance = calcBoxDistanceFromPoint(boxes[root], lon, lat);
+    if (rootDistance <= maxDistance)
+    {
+        queue.push(Candidate{rootDistance, root, true});
+    }
+    while (!queue.empty() && candidates.size() < k)
+    {
+        Candidate candidate = queue.top();
+        queue.pop();
+        if (!candidate.isNode)
+        {
+            /*! Every box left in the queue is at least as far as this link, so nothing nearer can follow */
+            LinkCandidate linkCandidate;
+            linkCandidate.link = store->getLink(candidate.ID);
+            linkCandidate.distance = linkCandidate.link->calcLinkDistanceFromPoint(lon, lat, linkCandidate.projLon, linkCandidate.projLat);
+            candidates.push_back(linkCandidate);
+            continue;
+        }
+        int node = candidate.ID;
+        int first = firstEntries[node];
+        int last = first + numOfEntries[node];
+        for (int e = first; e < last; e++)
+        {
+            int entry = entries[e];
+            double distance = (node < numOfLeaves) ? store->getLink(entry)->calcLinkDistanceFromPoint(lon, lat) : calcBoxDistanceFromPoint(boxes[entry], lon, lat);
+            if (distance <= maxDistance)
+            {
+                queue.push(Candidate{distance, entry, node >= numOfLeaves});
+            }
+        }
+    }
+}
+
+size_t RTree::getNumOfNodes() const
+{
+    return boxes.size();
+}
+
+int RTree::getHeight() const
+{
+    return height;
+}
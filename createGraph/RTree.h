@@ -0,0 +1,95 @@
+#ifndef RTREE_H
+#define RTREE_H
+
+#include "DataTypes.h"
+
+class Network;
+class Link;
+
+/*! This class is an R-tree over the bounding boxes of the links of a network, bulk-loaded with the
+ *  Sort-Tile-Recursive (STR) algorithm. Unlike the Grid, it adapts to the local density of the links
+ *  and it needs no cell size: every node holds up to maxEntries children, whatever their extent.
+ *
+ *  The tree is static; it is stored in flat arrays. Nodes [0, numOfLeaves) are the leaves and the
+ *  root is the last node. The entries of node n are entries[firstEntries[n] .. firstEntries[n] + numOfEntries[n]),
+ *  i.e. dense link indices for a leaf and node indices otherwise.
+ */
+class RTree
+{
+public:
+    /*! An axis-aligned rectangle in (lon, lat) = (x, y) coordinates */
+    struct Box
+    {
+        double minLon;
+        double minLat;
+        double maxLon;
+        double maxLat;
+    };
+
+    /*! A link returned by a nearest-links query */
+    struct LinkCandidate
+    {
+        Link* link;
+        /*! The distance of the query point from the link */
+        double distance;
+        /*! The point of the link that is nearest to the query point */
+        double projLon;
+        double projLat;
+    };
+
+private:
+    Network* network;
+    /*! The maximum number of entries of a node */
+    int maxEntries;
+    std::vector<Box> boxes;
+    std::vector<int> firstEntries;
+    std::vector<int> numOfEntries;
+    std::vector<int> entries;
+    int numOfLeaves;
+    int height;
+
+    /*! Bounding box of a link given by its dense index */
+    Box getLinkBox(const int link) const;
+
+public:
+    /*! Default constructor */
+    RTree();
+    /*! Constructor */
+    RTree(Network* _network, int _maxEntries = 16);
+    /*! Destructor */
+    ~RTree();
+
+    /*! Bulk-loads the tree with all the links of the network */
+    void build();
+
+    /*! Finds the link that is nearest to a point, as measured by Link::calcLinkDistanceFromPoint().
+     *  Nodes are visited best-first by the distance of their box from the point, so the search stops
+     *  as soon as no unvisited box can hold a nearer link. Among links at equal distance the one with
+     *  the smallest ID is returned, as the exhaustive search does.
+     *  @param lon the longitude of the point
+     *  @param lat the latitude of the point
+     *  @param distance set to the distance of the returned link from the point
+     *  @return the nearest link, or nullptr if the tree is empty
+     */
+    Link* findNearestLink(double lon, double lat, double& distance) const;
+
+    /*! Finds the k links that are nearest to a point, best-first as findNearestLink().
+     *  A box is never opened once k links nearer than it have been found or if it lies beyond maxDistance,
+     *  so only the neighbourhood of the point is visited.
+     *  @param lon the longitude of the point
+     *  @param lat the latitude of the point
+     *  @param k the maximum number of links to return
+     *  @param maxDistance links farther than this are not returned
+     *  @param candidates filled with up to k links, sorted by distance and then by ID
+     */
+    void findNearestLinks(double lon, double lat, size_t k, double maxDistance, std::vector<LinkCandidate>& candidates) const;
+
+    /*! Setters - Getters */
+    size_t getNumOfNodes() const;
+    int getHeight() const;
+
+    /*! Distance of a point from a box, 0 if the point is inside the box */
+    static double calcBoxDistanceFromPoint(const Box& box, double lon, double lat);
+};
+
+#endif  //  RTREE_H
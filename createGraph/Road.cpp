@@ -54,21 +54,21 @@ double Road::getLength() const
 	return length;
 }
 
-LinkMap* Road::getLinks()
+std::vector<Link*>* Road::getLinks()
 {
 	return &links;
 }
 
 Link* Road::getLink(const int linkID)
 {
-	if (links.find(linkID) != links.end())
+	for (Link* link : links)
 	{
-		return links[linkID];
-	}
-	else
-	{
-		return nullptr;
+		if (link->getID() == linkID)
+		{
+			return link;
+		}
 	}
+	return nullptr;
 }
 
 size_t Road::getNumOfLinks()
@@ -83,12 +83,12 @@ double Road::calRoadDistanceFromPoint(double pointX, double pointY)
 	if (!links.empty())
 	{
 		minDist = 0.0;
-		LinkMap::iterator it = links.begin();
-		minDist = it->second->calcLinkDistanceFromPoint(pointX, pointY);
+		auto it = links.begin();
+		minDist = (*it)->calcLinkDistanceFromPoint(pointX, pointY);
 		it++;
-		for (LinkMap::iterator it1 = it; it1 != links.end(); ++it1)
+		for (auto it1 = it; it1 != links.end(); ++it1)
 		{
-			tempDist = it1->second->calcLinkDistanceFromPoint(pointX, pointY);
+			tempDist = (*it1)->calcLinkDistanceFromPoint(pointX, pointY);
 			if (tempDist < minDist)
 			{
 				minDist = tempDist;
@@ -102,19 +102,16 @@ double Road::calRoadDistanceFromPoint(double pointX, double pointY)
 	return minDist;
 }
 
-void Road::addLink(const int linkID, Link* link)
+void Road::addLink(Link* link)
 {
-	if(links.find(linkID) == links.end())
-	{	
-		links.insert(std::make_pair(linkID, link));
-	}
+	links.push_back(link);
 }
 
 void Road::computeLength()
 {
 	length = 0.0;
-	for (LinkMap::iterator it = links.begin(); it != links.end(); ++it)
+	for (Link* link : links)
 	{
-		length += it->second->getLength();
+		length += link->getLength();
 	}
 }
\ No newline at end of file
@@ -12,7 +12,8 @@ class Road : public NetworkElement
 {
 	Node* startNode;
 	Node* endNode;	
-	LinkMap links;
+	/*! The links of the road, from the start node to the end node */
+	std::vector<Link*> links;
 	double length;
 public:
 	/*! Default constructor */
@@ -62,11 +63,11 @@ public:
  	 */
 	double getLength() const;
 
-	LinkMap* getLinks();
+	std::vector<Link*>* getLinks();
 
-	/*! Returns a specific link of the road using an index.
- 	 * @param index the index of the link to be returned. The index should a value from 0 to linksPtrVector.size() - 1.
- 	 * @return a specific link of the road using index
+	/*! Returns a specific link of the road using its ID.
+ 	 * @param linkID the ID of the link to be returned.
+ 	 * @return the link, or nullptr if it does not belong to the road
  	 */
 	Link* getLink(const int linkID);
 	size_t getNumOfLinks();
@@ -77,7 +78,10 @@ public:
  	 * @return the distance of the road from the point
  	 */
 	double calRoadDistanceFromPoint(double pointX, double pointY);
-	void addLink(const int linkID, Link* link);
+	/*! Appends a link at the end of the road.
+ 	 * @param link the link, which must start at the end node of the last link of the road.
+ 	 */
+	void addLink(Link* link);
 	void computeLength();
 	
 };
@@ -0,0 +1,324 @@
+#include "SyntheticNetwork.h"
+
+#include <random>
+
+namespace
+{
+    /*! The nodes and links being generated; links are (start, end) pairs of node indices */
+    struct Graph
+    {
+        std::vector<double> lons;
+        std::vector<double> lats;
+        std::vector< std::pair<int, int> > links;
+        /*! Whether every link belongs to a freeway */
+        std::vector<bool> freeway;
+
+        int addNode(double lon, double lat)
+        {
+            lons.push_back(lon);
+            lats.push_back(lat);
+            return static_cast<int>(lons.size()) - 1;
+        }
+
+        void addLink(int start, int end, bool isFreeway)
+        {
+            links.push_back(std::make_pair(start, end));
+            freeway.push_back(isFreeway);
+        }
+
+        /*! Joins two nodes with a chain of intermediate nodes at most spacing apart, shifted sideways by offset
+         *  (positive to the left of the direction from start to end); a one-way chain runs from start to end */
+        void addChain(int start, int end, double spacing, double offset, bool twoWay)
+        {
+            double dx = lons[end] - lons[start];
+            double dy = lats[end] - lats[start];
+            double length = std::sqrt(dx * dx + dy * dy);
+            int numOfSegments = std::max(1, static_cast<int>(std::ceil(length / spacing)));
+            double normalX = (length > 0.0) ? -dy / length : 0.0;
+            double normalY = (length > 0.0) ? dx / length : 0.0;
+            int previous = start;
+            for (int s = 1; s <= numOfSegments; s++)
+            {
+                int next = end;
+                if (s < numOfSegments)
+                {
+                    double t = static_cast<double>(s) / numOfSegments;
+                    next = addNode(lons[start] + t * dx + offset * normalX, lats[start] + t * dy + offset * normalY);
+                }
+                addLink(previous, next, true);
+                if (twoWay)
+                {
+                    addLink(next, previous, true);
+                }
+                previous = next;
+            }
+        }
+    };
+
+    const double streetSpacing = 0.01;
+    const double carriagewayOffset = 0.0005;
+    const double maxVDSOffset = 0.0003;
+}
+
+SyntheticNetwork::SyntheticNetwork() : seed(1), numOfCities(20), citySize(60), skew(1.0), numOfFreewaysPerCity(4), spacing(0.005), numOfVDS(0),
+    numOfWrittenNodes(0), numOfWrittenLinks(0), numOfWrittenVDS(0)
+{
+}
+
+SyntheticNetwork::SyntheticNetwork(unsigned int _seed, int _numOfCities) : seed(_seed), numOfCities(_numOfCities), citySize(60), skew(1.0), numOfFreewaysPerCity(4),
+    spacing(0.005), numOfVDS(0), numOfWrittenNodes(0), numOfWrittenLinks(0), numOfWrittenVDS(0)
+{
+}
+
+SyntheticNetwork::~SyntheticNetwork()
+{
+}
+
+void SyntheticNetwork::setSeed(const unsigned int _seed)
+{
+    seed = _seed;
+}
+
+unsigned int SyntheticNetwork::getSeed() const
+{
+    return seed;
+}
+
+void SyntheticNetwork::setNumOfCities(const int _numOfCities)
+{
+    numOfCities = _numOfCities;
+}
+
+int SyntheticNetwork::getNumOfCities() const
+{
+    return numOfCities;
+}
+
+void SyntheticNetwork::setCitySize(const int _citySize)
+{
+    citySize = _citySize;
+}
+
+int SyntheticNetwork::getCitySize() const
+{
+    return citySize;
+}
+
+void SyntheticNetwork::setSkew(const double _skew)
+{
+    skew = _skew;
+}
+
+double SyntheticNetwork::getSkew() const
+{
+    return skew;
+}
+
+void SyntheticNetwork::setNumOfFreewaysPerCity(const int _numOfFreewaysPerCity)
+{
+    numOfFreewaysPerCity = _numOfFreewaysPerCity;
+}
+
+int SyntheticNetwork::getNumOfFreewaysPerCity() const
+{
+    return numOfFreewaysPerCity;
+}
+
+void SyntheticNetwork::setSpacing(const double _spacing)
+{
+    spacing = _spacing;
+}
+
+double SyntheticNetwork::getSpacing() const
+{
+    return spacing;
+}
+
+void SyntheticNetwork::setNumOfVDS(const int _numOfVDS)
+{
+    numOfVDS = _numOfVDS;
+}
+
+int SyntheticNetwork::getNumOfVDS() const
+{
+    return numOfVDS;
+}
+
+size_t SyntheticNetwork::getNumOfWrittenNodes() const
+{
+    return numOfWrittenNodes;
+}
+
+size_t SyntheticNetwork::getNumOfWrittenLinks() const
+{
+    return numOfWrittenLinks;
+}
+
+size_t SyntheticNetwork::getNumOfWrittenVDS() const
+{
+    return numOfWrittenVDS;
+}
+
+bool SyntheticNetwork::write(const std::string& networkFilename, const std::string& VDSFilename)
+{
+    const double centreLon = -119.0;
+    const double centreLat = 37.0;
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    Graph graph;
+
+    // Cities, in the order of their size; the region gives every city the same area on average
+    double regionSize = 0.5 * std::sqrt(static_cast<double>(std::max(numOfCities, 1)));
+    std::vector<int> cityCentres;
+    std::vector<double> cityRadii;
+    for (int k = 0; k < numOfCities; k++)
+    {
+        int size = std::max(2, static_cast<int>(std::lround(citySize * std::pow(k + 1.0, -skew))));
+        double originLon = centreLon + (uniform(generator) - 0.5) * regionSize - 0.5 * size * streetSpacing;
+        double originLat = centreLat + (uniform(generator) - 0.5) * regionSize - 0.5 * size * streetSpacing;
+        int first = static_cast<int>(graph.lons.size());
+        // Node (i, j) of the city has index first + i * size + j
+        for (int i = 0; i < size; i++)
+        {
+            for (int j = 0; j < size; j++)
+            {
+                graph.addNode(originLon + (i + 0.6 * uniform(generator) - 0.3) * streetSpacing, originLat + (j + 0.6 * uniform(generator) - 0.3) * streetSpacing);
+            }
+        }
+        for (int i = 0; i < size; i++)
+        {
+            for (int j = 0; j < size; j++)
+            {
+                int node = first + i * size + j;
+                // The neighbours to the east and to the north
+                int neighbours[2] = {(i + 1 < size) ? node + size : -1, (j + 1 < size) ? node + 1 : -1};
+                for (int neighbour : neighbours)
+                {
+                    if (neighbour == -1 || uniform(generator) >= 0.8)
+                    {
+                        continue;
+                    }
+                    double direction = uniform(generator);
+                    if (direction < 0.75)
+                    {
+                        graph.addLink(node, neighbour, false);
+                    }
+                    if (direction < 0.5 || direction >= 0.75)
+                    {
+                        graph.addLink(neighbour, node, false);
+                    }
+                }
+            }
+        }
+        cityCentres.push_back(first + (size / 2) * size + size / 2);
+        cityRadii.push_back(0.5 * size * streetSpacing);
+    }
+
+    // Inter-city freeways: every city to the nearest city before it, which joins all the cities
+    for (int k = 1; k < numOfCities; k++)
+    {
+        int from = cityCentres[k];
+        int nearest = -1;
+        double nearestDistance = std::numeric_limits<double>::infinity();
+        for (int c = 0; c < k; c++)
+        {
+            double dx = graph.lons[cityCentres[c]] - graph.lons[from];
+            double dy = graph.lats[cityCentres[c]] - graph.lats[from];
+            double distance = dx * dx + dy * dy;
+            if (distance < nearestDistance)
+            {
+                nearestDistance = distance;
+                nearest = cityCentres[c];
+            }
+        }
+        // The carriageways lie on either side of the centre line, each to the right of its direction
+        graph.addChain(from, nearest, spacing, -carriagewayOffset, false);
+        graph.addChain(nearest, from, spacing, -carriagewayOffset, false);
+    }
+
+    // Radial freeways, evenly spread around the centre of every city and ending beyond its edge
+    for (int k = 0; k < numOfCities; k++)
+    {
+        double rotation = uniform(generator) * 2.0 * M_PI;
+        for (int f = 0; f < numOfFreewaysPerCity; f++)
+        {
+            double angle = rotation + 2.0 * M_PI * f / numOfFreewaysPerCity;
+            double length = cityRadii[k] + 0.05 + 0.2 * uniform(generator);
+            int centre = cityCentres[k];
+            int end = graph.addNode(graph.lons[centre] + length * std::cos(angle), graph.lats[centre] + length * std::sin(angle));
+            graph.addChain(centre, end, spacing, 0.0, true);
+        }
+    }
+
+    // VDS next to the links, most of them on freeways as in the real VDS file
+    std::vector<int> freewayLinks;
+    std::vector<int> streetLinks;
+    for (size_t l = 0; l < graph.links.size(); l++)
+    {
+        (graph.freeway[l] ? freewayLinks : streetLinks).push_back(static_cast<int>(l));
+    }
+    int numOfGeneratedVDS = (numOfVDS > 0) ? numOfVDS : static_cast<int>(freewayLinks.size() / 4);
+    std::vector< std::pair<double, double> > VDSPositions;
+    for (int v = 0; v < numOfGeneratedVDS && !graph.links.empty(); v++)
+    {
+        bool onFreeway = !freewayLinks.empty() && (streetLinks.empty() || uniform(generator) < 0.8);
+        const std::vector<int>& candidates = onFreeway ? freewayLinks : streetLinks;
+        int link = candidates[std::min(static_cast<size_t>(uniform(generator) * candidates.size()), candidates.size() - 1)];
+        int start = graph.links[link].first;
+        int end = graph.links[link].second;
+        double t = uniform(generator);
+        double lon = graph.lons[start] + t * (graph.lons[end] - graph.lons[start]) + (2.0 * uniform(generator) - 1.0) * maxVDSOffset;
+        double lat = graph.lats[start] + t * (graph.lats[end] - graph.lats[start]) + (2.0 * uniform(generator) - 1.0) * maxVDSOffset;
+        VDSPositions.push_back(std::make_pair(lat, lon));
+    }
+
+    std::shuffle(graph.links.begin(), graph.links.end(), generator);
+    std::ofstream out(networkFilename);
+    if (!out.is_open())
+    {
+        return false;
+    }
+    out << std::fixed << std::setprecision(6);
+    out << "ID,StartNodeID,StartNodeLon,StartNodeLat,EndNodeID,EndNodeLon,EndNodeLat\n";
+    for (size_t l = 0; l < graph.links.size(); l++)
+    {
+        int start = graph.links[l].first;
+        int end = graph.links[l].second;
+        out << l + 1 << "," << start + 1 << "," << graph.lons[start] << "," << graph.lats[start] << ","
+            << end + 1 << "," << graph.lons[end] << "," << graph.lats[end] << "\n";
+    }
+    out.close();
+    if (out.fail())
+    {
+        return false;
+    }
+
+    std::ofstream VDSOut(VDSFilename);
+    if (!VDSOut.is_open())
+    {
+        return false;
+    }
+    VDSOut << std::fixed << std::setprecision(6);
+    VDSOut << "ID,Lat,Lon\n";
+    for (size_t v = 0; v < VDSPositions.size(); v++)
+    {
+        VDSOut << 100000 + v << "," << VDSPositions[v].first << "," << VDSPositions[v].second << "\n";
+    }
+    VDSOut.close();
+    if (VDSOut.fail())
+    {
+        return false;
+    }
+
+    // A node of a city may have lost all its streets, it does not appear in the files then
+    std::vector<bool> used(graph.lons.size(), false);
+    for (const auto& link : graph.links)
+    {
+        used[link.first] = true;
+        used[link.second] = true;
+    }
+    numOfWrittenNodes = std::count(used.begin(), used.end(), true);
+    numOfWrittenLinks = graph.links.size();
+    numOfWrittenVDS = VDSPositions.size();
+    return true;
+}
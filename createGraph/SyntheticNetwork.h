@@ -0,0 +1,74 @@
+#ifndef SYNTHETICNETWORK_H
+#define SYNTHETICNETWORK_H
+
+#include "DataTypes.h"
+
+/*! This class generates a road network and VDS in the formats of the CALTRANS map and the VDS file, so
+ *  that building and matching can be measured without the CALTRANS map, and at any scale. The same
+ *  parameters and seed give the same files.
+ *
+ *  The network is made of:
+ *  - cities, placed at random in a square region whose area grows with their number, so that the density
+ *    of cities stays the same; every city is a jittered grid of streets 0.01 degrees apart, 80% of them
+ *    present, half two-way and half one-way. The k-th city has citySize * (k + 1)^-skew nodes per side,
+ *    so a skew of 0 gives equal cities and a larger skew concentrates the links in a few large cities;
+ *  - inter-city freeways, joining every city to the nearest city placed before it, each a pair of
+ *    one-way carriageways;
+ *  - radial freeways, numOfFreewaysPerCity two-way freeways from the centre of every city outwards, ending
+ *    in a dead end.
+ *  Freeways are chains of nodes spacing degrees apart, and every node of a chain is intermediate (one-way
+ *  or two-way pass-through), so long roads are built by Node::isIntermediateGetDepar().
+ *
+ *  Most VDS (80%) lie next to a freeway link, the others next to a street link, at a random point of the
+ *  link and at most 0.0003 degrees from it. The links are written in random order.
+ */
+class SyntheticNetwork
+{
+    unsigned int seed;
+    int numOfCities;
+    /*! The number of nodes per side of the largest city */
+    int citySize;
+    double skew;
+    int numOfFreewaysPerCity;
+    /*! The distance between consecutive nodes of a freeway, in degrees */
+    double spacing;
+    /*! 0 means one VDS per four freeway links */
+    int numOfVDS;
+    /*! The sizes of the files last written */
+    size_t numOfWrittenNodes;
+    size_t numOfWrittenLinks;
+    size_t numOfWrittenVDS;
+public:
+    /*! Default constructor */
+    SyntheticNetwork();
+    /*! Constructor */
+    SyntheticNetwork(unsigned int _seed, int _numOfCities);
+    /*! Destructor */
+    ~SyntheticNetwork();
+
+    /*! Setters - Getters */
+    void setSeed(const unsigned int _seed);
+    unsigned int getSeed() const;
+    void setNumOfCities(const int _numOfCities);
+    int getNumOfCities() const;
+    void setCitySize(const int _citySize);
+    int getCitySize() const;
+    void setSkew(const double _skew);
+    double getSkew() const;
+    void setNumOfFreewaysPerCity(const int _numOfFreewaysPerCity);
+    int getNumOfFreewaysPerCity() const;
+    void setSpacing(const double _spacing);
+    double getSpacing() const;
+    void setNumOfVDS(const int _numOfVDS);
+    int getNumOfVDS() const;
+    size_t getNumOfWrittenNodes() const;
+    size_t getNumOfWrittenLinks() const;
+    size_t getNumOfWrittenVDS() const;
+
+    /*! Generates the network and writes it with its VDS
+     *  @return false if one of the files cannot be written
+     */
+    bool write(const std::string& networkFilename, const std::string& VDSFilename);
+};
+
+#endif  //  SYNTHETICNETWORK_H
@@ -0,0 +1,151 @@
+#include "TimingReport.h"
+
+namespace
+{
+    /*! Quotes a string for JSON */
+    std::string quote(const std::string& s)
+    {
+        std::string quoted = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+                quoted += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                quoted += escaped;
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+        return quoted + "\"";
+    }
+}
+
+TimingReport::TimingReport() : command(""), totalSeconds(-1.0)
+{
+}
+
+TimingReport::TimingReport(std::string _command) : command(_command), totalSeconds(-1.0)
+{
+}
+
+TimingReport::~TimingReport()
+{
+}
+
+void TimingReport::setCommand(const std::string& _command)
+{
+    command = _command;
+}
+
+std::string TimingReport::getCommand() const
+{
+    return command;
+}
+
+void TimingReport::setParameter(const std::string& name, const std::string& value)
+{
+    for (auto& parameter : parameters)
+    {
+        if (parameter.first == name)
+        {
+            parameter.second = value;
+            return;
+        }
+    }
+    parameters.push_back(std::make_pair(name, value));
+}
+
+void TimingReport::addPhase(const std::string& name, double seconds)
+{
+    phases.push_back(Phase{name, seconds});
+}
+
+size_t TimingReport::getNumOfPhases() const
+{
+    return phases.size();
+}
+
+void TimingReport::setProfile(const std::vector<Profiler::Phase>& _profile)
+{
+    profile = _profile;
+}
+
+void TimingReport::setTotalSeconds(const double _totalSeconds)
+{
+    totalSeconds = _totalSeconds;
+}
+
+double TimingReport::getTotalSeconds() const
+{
+    return (totalSeconds >= 0.0) ? totalSeconds : getPhaseSeconds();
+}
+
+double TimingReport::getPhaseSeconds() const
+{
+    double phaseSeconds = 0.0;
+    for (const auto& phase : phases)
+    {
+        phaseSeconds += phase.seconds;
+    }
+    return phaseSeconds;
+}
+
+std::string TimingReport::toJSON() const
+{
+    std::ostringstream out;
+    out << std::setprecision(9);
+    out << "{\n  \"command\": " << quote(command) << ",\n  \"parameters\": {";
+    for (size_t i = 0; i < parameters.size(); i++)
+    {
+        out << ((i > 0) ? ", " : "") << quote(parameters[i].first) << ": " << quote(parameters[i].second);
+    }
+    out << "},\n  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        out << ((i > 0) ? "," : "") << "\n    {\"name\": " << quote(phases[i].name) << ", \"seconds\": " << phases[i].seconds << "}";
+    }
+    out << "\n  ],\n  \"totalSeconds\": " << getTotalSeconds() << ",\n  \"phaseSeconds\": " << getPhaseSeconds();
+    if (!profile.empty())
+    {
+        out << ",\n  \"profile\": [";
+        for (size_t i = 0; i < profile.size(); i++)
+        {
+            const Profiler::Phase& phase = profile[i];
+            out << ((i > 0) ? "," : "") << "\n    {\"name\": " << quote(phase.name) << ", \"depth\": " << phase.depth << ", \"seconds\": " << phase.seconds
+                << ", \"peakRSSDeltaKB\": " << phase.peakRSSDelta << ", \"counts\": {";
+            for (size_t c = 0; c < phase.counts.size(); c++)
+            {
+                out << ((c > 0) ? ", " : "") << quote(phase.counts[c].first) << ": " << phase.counts[c].second;
+            }
+            out << "}}";
+        }
+        out << "\n  ]";
+    }
+    out << "\n}\n";
+    return out.str();
+}
+
+bool TimingReport::write(const std::string& filename) const
+{
+    if (filename == "-")
+    {
+        std::cout << toJSON();
+        return true;
+    }
+    std::ofstream out(filename);
+    if (!out.is_open())
+    {
+        return false;
+    }
+    out << toJSON();
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,71 @@
+#ifndef TIMINGREPORT_H
+#define TIMINGREPORT_H
+
+#include "DataTypes.h"
+#include "Profiler.h"
+
+/*! This class collects the wall-clock time of the phases of a run (loading, index building, matching,
+ *  writing, ...) together with the parameters of the run, and writes them as a JSON document, so that
+ *  performance runs can be scripted and compared:
+ *
+ *  {"command": "match", "parameters": {"method": "pic", ...}, "phases": [{"name": "load", "seconds": 0.5}, ...], "totalSeconds": 0.9,
+ *   "phaseSeconds": 0.85}
+ *
+ *  Phases are kept in the order they are added; a phase that runs several times (e.g. in a benchmark)
+ *  appears once per run. totalSeconds is the wall-clock time of the whole run when it has been set, and
+ *  phaseSeconds the sum of the phases; the difference is the work no phase covers.
+ *
+ *  The phases recorded by the Profiler inside them (Network::createRoads, Grid::assignLinksToGrid, ...)
+ *  can be added as "profile", with their peak RSS delta in kilobytes and their counts; they are not part
+ *  of totalSeconds, since they overlap the phases above.
+ */
+class TimingReport
+{
+    struct Phase
+    {
+        std::string name;
+        double seconds;
+    };
+    std::string command;
+    /*! (name, value) pairs, in the order they are set */
+    std::vector< std::pair<std::string, std::string> > parameters;
+    std::vector<Phase> phases;
+    std::vector<Profiler::Phase> profile;
+    /*! The wall-clock time of the whole run, negative until it is set */
+    double totalSeconds;
+public:
+    /*! Default constructor */
+    TimingReport();
+    /*! Constructor */
+    TimingReport(std::string _command);
+    /*! Destructor */
+    ~TimingReport();
+
+    /*! Setters - Getters */
+    void setCommand(const std::string& _command);
+    std::string getCommand() const;
+    /*! Sets a parameter of the run, replacing an earlier value of the same name */
+    void setParameter(const std::string& name, const std::string& value);
+    /*! Appends a phase
+     *  @param name the name of the phase, e.g. "pic.match"
+     *  @param seconds its wall-clock time
+     */
+    void addPhase(const std::string& name, double seconds);
+    size_t getNumOfPhases() const;
+    /*! Sets the phases recorded by the Profiler */
+    void setProfile(const std::vector<Profiler::Phase>& _profile);
+    void setTotalSeconds(const double _totalSeconds);
+    /*! The wall-clock time of the whole run, or the sum of the phases if it has not been set */
+    double getTotalSeconds() const;
+    double getPhaseSeconds() const;
+
+    /*! Returns the report as a JSON document */
+    std::string toJSON() const;
+    /*! Writes the report as a JSON document
+     *  @param filename the file to write, "-" for stdout
+     *  @return false if the file cannot be written
+     */
+    bool write(const std::string& filename) const;
+};
+
+#endif  //  TIMINGREPORT_H
@@ -0,0 +1,127 @@
+#include <omp.h>
+
+#include "BenchmarkRunner.h"
+
+namespace
+{
+    /*! Discards everything written to it */
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override
+        {
+            return c;
+        }
+    };
+
+    double timeRun(const std::function<void(long)>& run, long iterations)
+    {
+        double start = omp_get_wtime();
+        run(iterations);
+        return omp_get_wtime() - start;
+    }
+}
+
+BenchmarkRunner::BenchmarkRunner() : minTime(0.2), repetitions(3), filter("")
+{
+}
+
+BenchmarkRunner::~BenchmarkRunner()
+{
+}
+
+void BenchmarkRunner::setMinTime(const double _minTime)
+{
+    minTime = _minTime;
+}
+
+void BenchmarkRunner::setRepetitions(const int _repetitions)
+{
+    repetitions = std::max(_repetitions, 1);
+}
+
+void BenchmarkRunner::setFilter(const std::string& _filter)
+{
+    filter = _filter;
+}
+
+void BenchmarkRunner::add(const std::string& name, std::function<void(long)> run, bool micro, double itemsPerIteration)
+{
+    benchmarks.push_back(Benchmark{name, run, micro, itemsPerIteration});
+}
+
+std::vector<BenchmarkRunner::Result> BenchmarkRunner::run()
+{
+    std::vector<Result> results;
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        long iterations = 1;
+        if (benchmark.micro)
+        {
+            while (timeRun(benchmark.run, iterations) < minTime && iterations < 1000000000L)
+            {
+                iterations *= 10;
+            }
+        }
+        Result result{benchmark.name, iterations, repetitions, 0.0, std::numeric_limits<double>::infinity(), benchmark.itemsPerIteration};
+        for (int r = 0; r < repetitions; r++)
+        {
+            double seconds = timeRun(benchmark.run, iterations) / iterations;
+            result.meanSeconds += seconds / repetitions;
+            result.minSeconds = std::min(result.minSeconds, seconds);
+        }
+        std::cerr << std::left << std::setw(48) << result.name << " " << std::right << std::setw(14) << result.meanSeconds * 1e9 << " ns  "
+                  << std::setw(12) << iterations << " iterations" << std::endl;
+        results.push_back(result);
+    }
+    std::cout.rdbuf(coutBuffer);
+    return results;
+}
+
+bool BenchmarkRunner::write(const std::vector<Result>& results, const std::string& filename, const std::string& format)
+{
+    std::ofstream file;
+    if (filename != "-")
+    {
+        file.open(filename);
+        if (!file.is_open())
+        {
+            return false;
+        }
+    }
+    std::ostream& out = (filename == "-") ? std::cout : file;
+    out << std::setprecision(9);
+    if (format == "json")
+    {
+        out << "{\n  \"threads\": " << omp_get_max_threads() << ",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& result = results[i];
+            out << ((i > 0) ? "," : "") << "\n    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"repetitions\": " << result.repetitions
+                << ", \"meanSeconds\": " << result.meanSeconds << ", \"minSeconds\": " << result.minSeconds
+                << ", \"itemsPerSecond\": " << result.itemsPerIteration / result.meanSeconds << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+    else
+    {
+        out << "name,iterations,repetitions,meanSeconds,minSeconds,itemsPerSecond\n";
+        for (const Result& result : results)
+        {
+            out << result.name << "," << result.iterations << "," << result.repetitions << "," << result.meanSeconds << "," << result.minSeconds << ","
+                << result.itemsPerIteration / result.meanSeconds << "\n";
+        }
+    }
+    if (filename != "-")
+    {
+        file.close();
+        return !file.fail();
+    }
+    return true;
+}
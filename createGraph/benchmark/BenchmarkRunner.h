@@ -0,0 +1,78 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include "DataTypes.h"
+
+#include <functional>
+
+/*! This class runs a list of benchmarks and writes their results as CSV or JSON, in the manner of
+ *  Google Benchmark.
+ *
+ *  A benchmark is a function that runs the measured operation a given number of times. A micro-benchmark
+ *  (one distance, one cell lookup) is calibrated first: the number of iterations is raised tenfold until
+ *  a run lasts at least the minimum time. A macro-benchmark (building a network, matching all VDS) runs
+ *  once per repetition. Every benchmark is repeated, and the mean and the minimum time per iteration over
+ *  the repetitions are reported.
+ *
+ *  The output of the measured code to std::cout is discarded while the benchmarks run, and the progress
+ *  is printed to std::cerr.
+ */
+class BenchmarkRunner
+{
+public:
+    struct Result
+    {
+        std::string name;
+        long iterations;
+        int repetitions;
+        /*! Seconds per iteration */
+        double meanSeconds;
+        double minSeconds;
+        /*! The number of items (e.g. VDS) an iteration processes, for the items per second */
+        double itemsPerIteration;
+    };
+private:
+    struct Benchmark
+    {
+        std::string name;
+        std::function<void(long)> run;
+        bool micro;
+        double itemsPerIteration;
+    };
+    std::vector<Benchmark> benchmarks;
+    double minTime;
+    int repetitions;
+    /*! Only the benchmarks whose name contains it are run */
+    std::string filter;
+public:
+    /*! Default constructor */
+    BenchmarkRunner();
+    /*! Destructor */
+    ~BenchmarkRunner();
+
+    /*! Setters - Getters */
+    /*! The minimum time of a run of a micro-benchmark, in seconds */
+    void setMinTime(const double _minTime);
+    void setRepetitions(const int _repetitions);
+    void setFilter(const std::string& _filter);
+
+    /*! Adds a benchmark
+     *  @param name the name of the benchmark, e.g. "PIC/threads:4/divideWith:2"
+     *  @param run runs the measured operation the given number of times
+     *  @param micro true if the number of iterations is to be calibrated, false to run it once per repetition
+     *  @param itemsPerIteration the number of items an iteration processes
+     */
+    void add(const std::string& name, std::function<void(long)> run, bool micro, double itemsPerIteration = 1.0);
+
+    /*! Runs the benchmarks that pass the filter, in the order they were added */
+    std::vector<Result> run();
+
+    /*! Write the results
+     *  @param filename the file to write, "-" for stdout
+     *  @param format "csv" or "json"
+     *  @return false if the file cannot be written
+     */
+    static bool write(const std::vector<Result>& results, const std::string& filename, const std::string& format);
+};
+
+#endif  //  BENCHMARKRUNNER_H
@@ -0,0 +1,3 @@
+#!/bin/bash
+# The benchmark has its own main(), so it is built from the sources of createGraph without ../main.cpp
+g++ -std=c++17 -lm -O3 -fopenmp -I.. *.cpp $(ls ../*.cpp | grep -v '/main.cpp$') -o benchmark.out
@@ -0,0 +1,346 @@
+#include <omp.h>
+
+#include "DataTypes.h"
+#include "Network.h"
+#include "VDS.h"
+#include "Grid.h"
+#include "Link.h"
+#include "GeoPos.h"
+#include "GraphStore.h"
+#include "LinkSegments.h"
+#include "Matchers.h"
+#include "BenchmarkRunner.h"
+#include "SyntheticNetwork.h"
+
+#include <memory>
+#include <random>
+
+/*! The results of the micro-benchmarks are accumulated here, so that the compiler cannot drop the measured calls */
+volatile double sink = 0.0;
+
+/*! The number of sample points (and links) the micro-benchmarks cycle through */
+const int numOfSamples = 4096;
+
+struct BenchmarkOptions
+{
+    /*! Empty: a synthetic network is generated */
+    std::string networkFilename;
+    std::string VDSFilename;
+    unsigned int seed = 1;
+    int numOfCities = 20;
+    std::vector<int> threads;
+    std::vector<double> divideWith = {0.0, 1.0, 2.0, 4.0};
+    std::string filter;
+    double minTime = 0.2;
+    int repetitions = 3;
+    std::string format = "csv";
+    std::string outFilename = "-";
+};
+
+void printUsage(std::ostream& out)
+{
+    out << "Usage: benchmark.out [options]\n"
+        << "  --network <csv> --vds <csv>  benchmark these files instead of a synthetic network\n"
+        << "  --seed <n> --cities <n>      seed and number of cities of the synthetic network (default 1, 20)\n"
+        << "  --threads <list>             comma-separated thread counts of the macro-benchmarks (default 1 and all)\n"
+        << "  --divide-with <list>         comma-separated cell sizes of PIC as in createGraph, 0 for automatic (default 0,1,2,4)\n"
+        << "  --filter <text>              run only the benchmarks whose name contains it\n"
+        << "  --min-time <s>               minimum time of a run of a micro-benchmark (default 0.2)\n"
+        << "  --repetitions <n>            repetitions of every benchmark (default 3)\n"
+        << "  --format csv|json            format of the results (default csv)\n"
+        << "  --output <file>              file of the results, - for stdout (default -)\n";
+}
+
+template <typename T>
+std::vector<T> parseList(const std::string& value, T (*parse)(const std::string&, size_t*))
+{
+    std::vector<T> list;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        list.push_back(parse(item, nullptr));
+    }
+    return list;
+}
+
+int parseInt(const std::string& s, size_t* pos)
+{
+    return std::stoi(s, pos);
+}
+
+double parseDouble(const std::string& s, size_t* pos)
+{
+    return std::stod(s, pos);
+}
+
+/*!
+ *Function that parses the command line.
+ *@return false if an option is unknown, misses its value or has an invalid value
+ */
+bool parseCommandLine(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value of " << option << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        try
+        {
+            if (option == "--network") options.networkFilename = value;
+            else if (option == "--vds") options.VDSFilename = value;
+            else if (option == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+            else if (option == "--cities") options.numOfCities = std::stoi(value);
+            else if (option == "--threads") options.threads = parseList<int>(value, parseInt);
+            else if (option == "--divide-with") options.divideWith = parseList<double>(value, parseDouble);
+            else if (option == "--filter") options.filter = value;
+            else if (option == "--min-time") options.minTime = std::stod(value);
+            else if (option == "--repetitions") options.repetitions = std::stoi(value);
+            else if (option == "--format") options.format = value;
+            else if (option == "--output") options.outFilename = value;
+            else
+            {
+                std::cerr << "Unknown option " << option << "\n";
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "Invalid value of " << option << ": " << value << "\n";
+            return false;
+        }
+    }
+    if (options.networkFilename.empty() != options.VDSFilename.empty())
+    {
+        std::cerr << "The network and the VDS files must be given together\n";
+        return false;
+    }
+    if (options.format != "csv" && options.format != "json")
+    {
+        std::cerr << "Unknown format " << options.format << "\n";
+        return false;
+    }
+    if (options.threads.empty())
+    {
+        options.threads.push_back(1);
+        if (omp_get_max_threads() > 1)
+        {
+            options.threads.push_back(omp_get_max_threads());
+        }
+    }
+    return true;
+}
+
+std::string formatNumber(double value)
+{
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+/*! Registers the micro-benchmarks of the distance of a point from a link */
+void addDistanceBenchmarks(BenchmarkRunner& runner, Network* network)
+{
+    GraphStore* store = network->getGraphStore();
+    int numOfLinks = static_cast<int>(store->getNumOfLinks());
+    double minLon = 0.0;
+    double maxLon = 0.0;
+    double minLat = 0.0;
+    double maxLat = 0.0;
+    network->getMinMaxPosCoords(minLon, maxLon, minLat, maxLat);
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> linkDistribution(0, numOfLinks - 1);
+    std::uniform_real_distribution<double> lonDistribution(minLon, maxLon);
+    std::uniform_real_distribution<double> latDistribution(minLat, maxLat);
+    // The sampled links and points, shared by the benchmarks
+    auto links = std::make_shared< std::vector<Link*> >();
+    auto lons = std::make_shared< std::vector<double> >();
+    auto lats = std::make_shared< std::vector<double> >();
+    for (int s = 0; s < numOfSamples; s++)
+    {
+        links->push_back(store->getLink(linkDistribution(generator)));
+        lons->push_back(lonDistribution(generator));
+        lats->push_back(latDistribution(generator));
+    }
+    runner.add("Link::calcLinkDistanceFromPoint", [links, lons, lats](long iterations)
+    {
+        double sum = 0.0;
+        for (long i = 0; i < iterations; i++)
+        {
+            int s = static_cast<int>(i % numOfSamples);
+            sum += (*links)[s]->calcLinkDistanceFromPoint((*lons)[s], (*lats)[s]);
+        }
+        sink = sum;
+    }, true);
+
+    // The kernel of the Greedy matcher, one point against a tile of links per iteration
+    auto segments = std::make_shared<LinkSegments>();
+    segments->build(store);
+    int tileSize = std::min(numOfSamples, numOfLinks);
+    runner.add(std::string("LinkSegments::calcDistancesFromPoint/") + LinkSegments::getInstructionSet() + "/links:" + std::to_string(tileSize),
+        [segments, lons, lats, tileSize](long iterations)
+    {
+        std::vector<double> distances(tileSize);
+        double sum = 0.0;
+        for (long i = 0; i < iterations; i++)
+        {
+            int s = static_cast<int>(i % numOfSamples);
+            segments->calcDistancesFromPoint((*lons)[s], (*lats)[s], 0, tileSize, distances.data());
+            sum += distances[s % tileSize];
+        }
+        sink = sum;
+    }, true, tileSize);
+}
+
+/*! Registers the micro-benchmarks of the cell lookup, one per grid size */
+void addCellLookupBenchmarks(BenchmarkRunner& runner, Network* network, const std::vector<double>& divideWith, double maxLengthOfLink)
+{
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    for (double d : divideWith)
+    {
+        double dimension = chooseCellSize(network, maxLengthOfLink, d);
+        auto grid = std::make_shared<Grid>(dimension, network);
+        grid->build();
+        grid->assignLinksToGrid();
+        // The positions of the VDS, the points the matchers look up
+        auto positions = std::make_shared< std::vector<GeoPos> >();
+        for (int s = 0; s < numOfSamples && numOfVDS > 0; s++)
+        {
+            VDS* v = vds->at(s % numOfVDS);
+            positions->push_back(GeoPos(v->getLat(), v->getLon()));
+        }
+        runner.add("Grid::getCellContainingPos/divideWith:" + formatNumber(d), [grid, positions](long iterations)
+        {
+            size_t found = 0;
+            for (long i = 0; i < iterations; i++)
+            {
+                found += (grid->getCellContainingPos(&(*positions)[i % positions->size()]) != nullptr);
+            }
+            sink = static_cast<double>(found);
+        }, true);
+    }
+}
+
+/*! Registers the macro-benchmarks: building the network, and every matcher, for every number of threads and grid size */
+void addMacroBenchmarks(BenchmarkRunner& runner, Network* network, const BenchmarkOptions& options, double maxLengthOfLink)
+{
+    double numOfVDS = static_cast<double>(network->getNumOfVDS());
+    for (int numThreads : options.threads)
+    {
+        std::string networkFilename = options.networkFilename;
+        std::string VDSFilename = options.VDSFilename;
+        runner.add("Network::build/threads:" + std::to_string(numThreads), [networkFilename, VDSFilename, numThreads](long iterations)
+        {
+            for (long i = 0; i < iterations; i++)
+            {
+                Network* built = new Network(networkFilename, VDSFilename);
+                built->setNumThreads(numThreads);
+                built->build();
+                delete built;
+            }
+        }, false, static_cast<double>(network->getNumOfLinks()));
+    }
+    for (int numThreads : options.threads)
+    {
+        runner.add("Greedy/threads:" + std::to_string(numThreads), [network, numThreads](long iterations)
+        {
+            std::vector<int> linkOfVDS;
+            for (long i = 0; i < iterations; i++)
+            {
+                findLinksOfVDS_Greedy(network, numThreads, linkOfVDS);
+            }
+        }, false, numOfVDS);
+        for (double d : options.divideWith)
+        {
+            double dimension = chooseCellSize(network, maxLengthOfLink, d);
+            runner.add("PIC/threads:" + std::to_string(numThreads) + "/divideWith:" + formatNumber(d), [network, numThreads, dimension](long iterations)
+            {
+                std::vector<int> linkOfVDS;
+                for (long i = 0; i < iterations; i++)
+                {
+                    findLinksOfVDS_PIC(network, dimension, numThreads, linkOfVDS);
+                }
+            }, false, numOfVDS);
+        }
+        runner.add("RTree/threads:" + std::to_string(numThreads), [network, numThreads](long iterations)
+        {
+            std::vector<int> linkOfVDS;
+            for (long i = 0; i < iterations; i++)
+            {
+                findLinksOfVDS_RTree(network, numThreads, linkOfVDS);
+            }
+        }, false, numOfVDS);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    // Without input files a synthetic network is written into a directory of its own, removed at the end
+    std::string directory;
+    if (options.networkFilename.empty())
+    {
+        char directoryTemplate[] = "/tmp/createGraph-benchmark-XXXXXX";
+        if (mkdtemp(directoryTemplate) == nullptr)
+        {
+            std::cerr << "Cannot create a temporary directory\n";
+            return 1;
+        }
+        directory = directoryTemplate;
+        options.networkFilename = directory + "/network.csv";
+        options.VDSFilename = directory + "/VDS.csv";
+        SyntheticNetwork synthetic(options.seed, options.numOfCities);
+        if (!synthetic.write(options.networkFilename, options.VDSFilename))
+        {
+            std::cerr << "Cannot write the synthetic network into " << directory << "\n";
+            return 1;
+        }
+    }
+
+    // Only the results go to stdout, the messages of the code under test are discarded
+    std::streambuf* coutBuffer = std::cout.rdbuf(nullptr);
+    Network* network = new Network(options.networkFilename, options.VDSFilename);
+    network->build();
+    network->setPosLimits();
+    std::cerr << "Network: " << network->getNumOfNodes() << " nodes, " << network->getNumOfLinks() << " links, " << network->getNumOfVDS() << " VDS" << std::endl;
+    double minLengthOfLink = 0.0;
+    double maxLengthOfLink = 0.0;
+    double meanLengthOfLink = 0.0;
+    network->findMinMaxMeanLengthOfLinks(minLengthOfLink, maxLengthOfLink, meanLengthOfLink);
+
+    BenchmarkRunner runner;
+    runner.setMinTime(options.minTime);
+    runner.setRepetitions(options.repetitions);
+    runner.setFilter(options.filter);
+    addDistanceBenchmarks(runner, network);
+    addCellLookupBenchmarks(runner, network, options.divideWith, maxLengthOfLink);
+    addMacroBenchmarks(runner, network, options, maxLengthOfLink);
+    std::vector<BenchmarkRunner::Result> results = runner.run();
+    std::cout.rdbuf(coutBuffer);
+    int exitStatus = 0;
+    if (!BenchmarkRunner::write(results, options.outFilename, options.format))
+    {
+        std::cerr << "Cannot write " << options.outFilename << "\n";
+        exitStatus = 1;
+    }
+
+    delete network;
+    if (!directory.empty())
+    {
+        std::remove(options.networkFilename.c_str());
+        std::remove(options.VDSFilename.c_str());
+        rmdir(directory.c_str());
+    }
+    return exitStatus;
+}
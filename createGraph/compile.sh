@@ -1,2 +1,2 @@
 #!/bin/bash
-g++ -std=c++11 -lm -O3 -fopenmp *.cpp -o createGraph.out 
\ No newline at end of file
+g++ -std=c++17 -lm -O3 -fopenmp *.cpp -o createGraph.out 
\ No newline at end of file
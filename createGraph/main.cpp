@@ -3,10 +3,19 @@
 #include "DataTypes.h"
 #include "Network.h"
 #include "VDS.h"
-#include "Grid.h"
 #include "Cell.h"
+#include "Node.h"
 #include "Link.h"
 #include "Road.h"
+#include "NetworkSnapshot.h"
+#include "RTree.h"
+#include "GraphStore.h"
+#include "MatchingService.h"
+#include "TimingReport.h"
+#include "Matchers.h"
+#include "Profiler.h"
+#include "SyntheticNetwork.h"
+#include "AdjacencyExporter.h"
 
 std::string getExecutablePath()
 {
@@ -29,157 +38,563 @@ std::string getExecutablePathAndMatchItWithFilename(std::string fileName)
     return ss.str();
 }
 
-Network* loadNetwork()
+/*!
+ *Function that loads the network, from its snapshot if the snapshot has been built from the csv files as they are now.
+ *@param snapshotFilename the snapshot of the built network, rebuilt whenever the csv files differ from those it records; empty to always build from the csv files
+ *@param numThreads the number of threads that build the network, 0 for all of them
+ *@param report if not null, the time of the "load" phase is added to it
+ *@return the network, or nullptr if a csv file cannot be read or the network has no links
+ */
+Network* loadNetwork(std::string networkFilename, std::string VDSFilename, std::string snapshotFilename, int numThreads = 0, TimingReport* report = nullptr)
 {
-    std::string networkFilename = getExecutablePathAndMatchItWithFilename("Map/CALTRANS_ALLCALI.csv");
-    std::string VDSFilename = getExecutablePathAndMatchItWithFilename("VDS.csv");
+    double start = omp_get_wtime();
+    // access() rather than opening the files, a pipe can be read only once
+    for (const std::string& filename : {networkFilename, VDSFilename})
+    {
+        if (access(filename.c_str(), R_OK) != 0)
+        {
+            std::cerr << "Cannot read " << filename << "\n";
+            return nullptr;
+        }
+    }
     Network* network = new Network(networkFilename, VDSFilename);
-    network->build();
+    network->setNumThreads(numThreads);
+    NetworkSnapshot snapshot(snapshotFilename);
+    StringVector sourceFilenames = {networkFilename, VDSFilename};
+    bool restored = !snapshotFilename.empty() && snapshot.isUpToDate(sourceFilenames) && snapshot.read(network);
+    if (!restored)
+    {
+        network->build();
+    }
+    if (network->getNumOfLinks() == 0)
+    {
+        std::cerr << "No links in " << networkFilename << "\n";
+        delete network;
+        return nullptr;
+    }
+    if (!restored && !snapshotFilename.empty())
+    {
+        snapshot.write(network, sourceFilenames);
+    }
+    if (report != nullptr)
+    {
+        report->addPhase("load", omp_get_wtime() - start);
+    }
     return network;
 }
 
-void matchVDSToRoads_Greedy(Network* network, std::string outFilename)
+/*! The network of the interactive mode: the files next to the executable, with the snapshot kept next to the map */
+Network* loadNetwork()
 {
-    std::cout << "Map-matching VDS to links...\n";
-    LinkMap* links = network->getLinks();
+    return loadNetwork(getExecutablePathAndMatchItWithFilename("Map/CALTRANS_ALLCALI.csv"), getExecutablePathAndMatchItWithFilename("VDS.csv"),
+                       getExecutablePathAndMatchItWithFilename("Map/CALTRANS_ALLCALI.snapshot"));
+}
+
+/*!
+ *Function that writes the road of every matched VDS into a file.
+ *@param linkOfVDS the dense index of the link of every VDS (by dense index), -1 if it has not been matched
+ *@return false if the file cannot be written
+ */
+bool writeRoadsOfVDS(Network* network, const std::vector<int>& linkOfVDS, std::string outFilename, TimingReport* report = nullptr)
+{
+    double start = omp_get_wtime();
+    GraphStore* store = network->getGraphStore();
     VDSMap* vds = network->getVDS();
-    std::map<int, int> vdsID_roadID;
-    
-    clock_t startTime = clock();
-    for (auto it = vds->begin(); it != vds->end(); ++it)
-    {
-        int vdsID = it->first;
-        double lat = it->second->getLat();
-        double lon = it->second->getLon();
-        auto it1 = links->begin();
-        double minDistance = it1->second->calcLinkDistanceFromPoint(lon, lat);
-        Link* linkOfVDS = it1->second;
-        ++it1;
-        for (auto it2 = it1; it2 != links->end(); ++it2)
-        {
-            double distance = it2->second->calcLinkDistanceFromPoint(lon, lat);
-            if (distance < minDistance)
+    // Write VDS ID - road ID pairs into file, in VDS ID order (the order of the dense indices)
+    std::ofstream out(outFilename);
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot write " << outFilename << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < linkOfVDS.size(); i++)
+    {
+        if (linkOfVDS[i] != -1)
+        {
+            Road* road = store->getLinkRoad(linkOfVDS[i]);
+            if (road != nullptr)
             {
-                minDistance = distance;
-                linkOfVDS = it2->second;
+                out << vds->getID(static_cast<int>(i)) << "," << road->getID() << "\n";
             }
         }
-        int roadID = -1;
-        Road* roadOfVDS = linkOfVDS->getRoadOfLink();
-        if (roadOfVDS != nullptr)
-        {
-            roadID = roadOfVDS->getID();
-            vdsID_roadID.insert(std::make_pair(vdsID, roadID));   
-        }
     }
-    clock_t endTime = clock();
-    std::cout << "Matched!\n";
-    
-    // Write VDS ID - link ID pairs into file
-    std::ofstream out(outFilename);
-    for (const auto& x : vdsID_roadID)
+    out.close();
+    if (out.fail())
     {
-        int vdsID = x.first;
-        int roadID = x.second;
-        out << vdsID << "," << roadID << std::endl;
+        std::cerr << "Cannot write " << outFilename << "\n";
+        return false;
     }
-    out.close();
+    if (report != nullptr)
+    {
+        report->addPhase("write", omp_get_wtime() - start);
+    }
+    return true;
+}
 
-    double elapsedTimeInSecs = (double)(endTime - startTime) / (double)CLOCKS_PER_SEC;
-    double elapsedTimeInMins = elapsedTimeInSecs / 60.0;
-    std::cout << "Elapsed Time in seconds: " << elapsedTimeInSecs << std::endl;
-    std::cout << "Elapsed Time in minutes: " << elapsedTimeInMins << std::endl;
+bool matchVDSToRoads_Greedy(Network* network, std::string outFilename, int numThreads, TimingReport* report = nullptr)
+{
+    std::cout << "Map-matching VDS to links...\n";
+    std::vector<int> linkOfVDS;
+    findLinksOfVDS_Greedy(network, numThreads, linkOfVDS, report);
+    std::cout << "Matched!\n";
+    return writeRoadsOfVDS(network, linkOfVDS, outFilename, report);
 }
 
-void matchVDSToRoads_PIC(Network* network, double dimension, std::string outFilename, int numThreads)
+bool matchVDSToRoads_PIC(Network* network, double dimension, std::string outFilename, int numThreads, TimingReport* report = nullptr)
 {
     std::cout << "Map-matching VDS to links...\n";
-    // Create Grid
-    Grid* grid = new Grid(dimension, network);
-    grid->build();
-    // Assign links to Grid
-    grid->assignLinksToGrid();
-    // Match VDS to links
-    VDSMap* vds = network->getVDS();
-    std::map<int, int> vdsID_roadID;
-    int i;
+    std::vector<int> linkOfVDS;
+    findLinksOfVDS_PIC(network, dimension, numThreads, linkOfVDS, report);
+    std::cout << "Matched!\n";
+    return writeRoadsOfVDS(network, linkOfVDS, outFilename, report);
+}
 
-/********************************************************************************** Parallel section ******************************************************************************************************/
-    double start = omp_get_wtime();
-#pragma omp parallel for num_threads(numThreads) private(i)
-    for (i = 0; i < vds->size(); i++)
+bool matchVDSToRoads_RTree(Network* network, std::string outFilename, int numThreads, TimingReport* report = nullptr)
+{
+    std::cout << "Map-matching VDS to links...\n";
+    std::vector<int> linkOfVDS;
+    findLinksOfVDS_RTree(network, numThreads, linkOfVDS, report);
+    std::cout << "Matched!\n";
+    return writeRoadsOfVDS(network, linkOfVDS, outFilename, report);
+}
+
+/*!
+ *Function that compares the links found by a matcher with those of the Greedy matcher (the oracle).
+ *A different link at the same distance is a tie and it is accepted.
+ *@return the number of VDS for which the matcher has found a farther link or no link at all
+ */
+int compareWithGreedy(Network* network, const std::string& method, const std::vector<int>& linkOfVDS, const std::vector<int>& greedyLinkOfVDS)
+{
+    GraphStore* store = network->getGraphStore();
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    int same = 0;
+    int ties = 0;
+    int missed = 0;
+    int wrong = 0;
+    for (int i = 0; i < numOfVDS; i++)
     {
-        auto it = vds->begin();
-        std::advance(it, i);
-        VDS* vds = it->second;
-        Cell* cell = grid->getCellContainingVDS(vds);
-        #pragma omp critical
+        if (linkOfVDS[i] == greedyLinkOfVDS[i])
+        {
+            same++;
+        }
+        else if (linkOfVDS[i] == -1)
+        {
+            missed++;
+        }
+        else
         {
-            if (cell != nullptr)
+            VDS* v = vds->at(i);
+            double distance = store->getLink(linkOfVDS[i])->calcLinkDistanceFromPoint(v->getLon(), v->getLat());
+            double greedyDistance = store->getLink(greedyLinkOfVDS[i])->calcLinkDistanceFromPoint(v->getLon(), v->getLat());
+            if (distance == greedyDistance)
+            {
+                ties++;
+            }
+            else
             {
-                std::vector<Link*>* linksOfCell = cell->getLinksOfCell();
-                if (linksOfCell->size() > 0)
+                wrong++;
+                if (wrong <= 10)
                 {
-                    double minDistance = -1.0;
-                    double distance = -1.0;
-                    auto it1 = linksOfCell->begin();
-                    Link* link = *it1;
-                    Link* linkOfVDS = link;
-                    distance = link->calcLinkDistanceFromPoint(vds->getLon(), vds->getLat());
-                    minDistance = distance;
-                    it1++;
-                    for (auto it2 = it1; it2 != linksOfCell->end(); ++it2)
-                    {
-                        link = *it2;
-                        distance = link->calcLinkDistanceFromPoint(vds->getLon(), vds->getLat());
-                        if (distance < minDistance)
-                        {
-                            minDistance = distance;
-                            linkOfVDS = link;
-                        }
-                    }
-                    int roadID = -1;
-                    Road* roadOfVDS = linkOfVDS->getRoadOfLink();
-                    if (roadOfVDS != nullptr)
-                    {
-                        roadID = roadOfVDS->getID();
-                        vdsID_roadID.insert(std::make_pair(vds->getID(), roadID));
-                    }
+                    std::cout << "  VDS " << vds->getID(i) << ": link " << store->getLinkID(linkOfVDS[i]) << " at " << distance
+                              << " instead of link " << store->getLinkID(greedyLinkOfVDS[i]) << " at " << greedyDistance << std::endl;
                 }
             }
         }
     }
+    std::cout << method << ": " << same << " same, " << ties << " ties, " << missed << " missed, " << wrong << " farther (of " << numOfVDS << " VDS)" << std::endl;
+    return missed + wrong;
+}
+
+/*!
+ *Function that runs the PIC and R-tree matchers and checks their links against those of the Greedy matcher.
+ *@return the number of VDS on which a matcher disagrees with Greedy, summed over the matchers
+ */
+int verifyMatchersAgainstGreedy(Network* network, double dimension, int numThreads, TimingReport* report = nullptr)
+{
+    std::vector<int> greedyLinkOfVDS;
+    std::vector<int> linkOfVDS;
+    std::cout << "Greedy (oracle)\n";
+    findLinksOfVDS_Greedy(network, numThreads, greedyLinkOfVDS, report);
+    int disagreements = 0;
+    std::cout << "PIC\n";
+    findLinksOfVDS_PIC(network, dimension, numThreads, linkOfVDS, report);
+    disagreements += compareWithGreedy(network, "PIC", linkOfVDS, greedyLinkOfVDS);
+    std::cout << "R-tree\n";
+    findLinksOfVDS_RTree(network, numThreads, linkOfVDS, report);
+    disagreements += compareWithGreedy(network, "R-tree", linkOfVDS, greedyLinkOfVDS);
+    return disagreements;
+}
+
+/*!
+ *Function that writes the k nearest candidate links of every VDS into a file.
+ *@return false if the file cannot be written
+ */
+bool matchVDSToLinkCandidates_RTree(Network* network, std::string outFilename, int k, double maxDistance, int numThreads, TimingReport* report = nullptr)
+{
+    std::cout << "Finding candidate links of VDS...\n";
+    double buildStart = omp_get_wtime();
+    RTree* rtree = new RTree(network);
+    rtree->build();
+    double buildEnd = omp_get_wtime();
+    VDSMap* vds = network->getVDS();
+    int numOfVDS = static_cast<int>(vds->size());
+    // One candidate list per VDS (by dense index)
+    std::vector< std::vector<RTree::LinkCandidate> > candidatesOfVDS(numOfVDS);
+
+    double start = omp_get_wtime();
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+    for (int i = 0; i < numOfVDS; i++)
+    {
+        VDS* v = vds->at(i);
+        rtree->findNearestLinks(v->getLon(), v->getLat(), k, maxDistance, candidatesOfVDS[i]);
+    }
     double end = omp_get_wtime();
-/********************************************************************************** End of parallel section ***********************************************************************************************/
-    std::cout << "Matched!\n";
+    std::cout << "Done!\n";
     std::cout << "Elapsed time: " << end - start << std::endl;
-    
-    delete grid;
 
-    // Write VDS ID - link ID pairs into file
+    delete rtree;
+
+    // Write VDS ID, rank, link ID, road ID, distance and projection point of every candidate, in VDS ID order
+    double writeStart = omp_get_wtime();
     std::ofstream out(outFilename);
-    for (const auto& x : vdsID_roadID)
-        out << x.first << "," << x.second << std::endl;
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot write " << outFilename << "\n";
+        return false;
+    }
+    out << std::setprecision(10);
+    out << "VDS,Rank,Link,Road,Distance,ProjLon,ProjLat\n";
+    for (int i = 0; i < numOfVDS; i++)
+    {
+        for (size_t rank = 0; rank < candidatesOfVDS[i].size(); rank++)
+        {
+            const RTree::LinkCandidate& candidate = candidatesOfVDS[i][rank];
+            Road* road = candidate.link->getRoadOfLink();
+            out << vds->getID(i) << "," << rank + 1 << "," << candidate.link->getID() << "," << ((road != nullptr) ? road->getID() : -1) << ","
+                << candidate.distance << "," << candidate.projLon << "," << candidate.projLat << "\n";
+        }
+    }
     out.close();
+    if (out.fail())
+    {
+        std::cerr << "Cannot write " << outFilename << "\n";
+        return false;
+    }
+    if (report != nullptr)
+    {
+        report->addPhase("rtree.build", buildEnd - buildStart);
+        report->addPhase("candidates.match", end - start);
+        report->addPhase("write", omp_get_wtime() - writeStart);
+    }
+    return true;
+}
+
+/*!
+ *Function that prints the extent of the network, the numbers of its elements and the lengths of its links and roads.
+ */
+void printNetworkInfo(Network* network)
+{
+    double minLon = -1.0;
+    double maxLon = -1.0;
+    double minLat = -1.0;
+    double maxLat = -1.0;
+    double minLengthOfLink = -1.0;
+    double maxLengthOfLink = -1.0;
+    double meanLengthOfLink = -1.0;
+    double minLengthOfRoad = -1.0;
+    double maxLengthOfRoad = -1.0;
+    double meanLengthOfRoad = -1.0;
+
+    network->setPosLimits();
+    network->getMinMaxPosCoords(minLon, maxLon, minLat, maxLat);
+    network->findMinMaxMeanLengthOfLinks(minLengthOfLink, maxLengthOfLink, meanLengthOfLink);
+    network->findMinMaxMeanLengthOfRoads(minLengthOfRoad, maxLengthOfRoad, meanLengthOfRoad);
+    size_t numOfNodes = network->getNumOfNodes();
+    size_t numOfLinks = network->getNumOfLinks();
+    size_t numOfRoads = network->getNumOfRoads();
+    size_t numOfVDS = network->getNumOfVDS();
+    double lonSize = maxLon - minLon;
+    double latSize = maxLat - minLat;
+    double meanNumOfLinksPerRoad = network->getMeanNumOfLinksPerRoad();
+
+    std::cout << "Network info:\n";
+    std::cout << "minLat: " << minLat << std::endl;
+    std::cout << "minLon: " << minLon << std::endl;
+
+    std::cout << "maxLat: " << maxLat << std::endl;
+    std::cout << "maxLon: " << maxLon << std::endl;
+    
+    std::cout << "latSize: " << latSize << std::endl;
+    std::cout << "lonSize: " << lonSize << std::endl;
+    
+    std::cout << "Nodes: " << numOfNodes << std::endl;
+    std::cout << "Links: " << numOfLinks << std::endl;
+    std::cout << "Roads: " << numOfRoads << std::endl;
+    std::cout << "Mean num of links per road: " << meanNumOfLinksPerRoad << std::endl;
+    std::cout << "VDS: " << numOfVDS << std::endl;
+
+    std::cout << "Min link length: " << minLengthOfLink << std::endl;
+    std::cout << "Max link length: " << maxLengthOfLink << std::endl;
+    std::cout << "Mean link length: " << meanLengthOfLink << std::endl;
+ 
+    std::cout << "Min road length: " << minLengthOfRoad << std::endl;
+    std::cout << "Max road length: " << maxLengthOfRoad << std::endl;
+    std::cout << "Mean road length: " << meanLengthOfRoad << std::endl;
+}
+
+/*! Whether two neighbour or incidence lists hold the same dense indices, in the same order */
+bool sameIndices(const LinkRange& a, const LinkRange& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a.indexAt(i) != b.indexAt(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ *Function that compares a network restored from a snapshot with the network built from the csv files: every node,
+ *link (with its neighbour lists), road and VDS must be the same, down to the last bit of every coordinate and length.
+ *@return the number of mismatching elements
+ */
+int compareWithSnapshot(Network* built, Network* restored)
+{
+    int mismatches = 0;
+    auto mismatch = [&mismatches](const std::string& what, int ID)
+    {
+        mismatches++;
+        if (mismatches <= 10)
+        {
+            std::cout << "  " << what << " " << ID << " differs" << std::endl;
+        }
+    };
+    GraphStore* a = built->getGraphStore();
+    GraphStore* b = restored->getGraphStore();
+    if (a->getNumOfNodes() != b->getNumOfNodes() || a->getNumOfLinks() != b->getNumOfLinks() || built->getNumOfRoads() != restored->getNumOfRoads()
+        || built->getNumOfVDS() != restored->getNumOfVDS())
+    {
+        std::cout << "Snapshot: " << b->getNumOfNodes() << " nodes, " << b->getNumOfLinks() << " links, " << restored->getNumOfRoads() << " roads, "
+                  << restored->getNumOfVDS() << " VDS instead of " << a->getNumOfNodes() << ", " << a->getNumOfLinks() << ", " << built->getNumOfRoads()
+                  << ", " << built->getNumOfVDS() << std::endl;
+        return 1;
+    }
+
+    int numOfNodes = static_cast<int>(a->getNumOfNodes());
+    for (int n = 0; n < numOfNodes; n++)
+    {
+        if (a->getNodeID(n) != b->getNodeID(n) || a->getNodeLat(n) != b->getNodeLat(n) || a->getNodeLon(n) != b->getNodeLon(n)
+            || !sameIndices(a->getIncomingLinks(n), b->getIncomingLinks(n)) || !sameIndices(a->getOutgoingLinks(n), b->getOutgoingLinks(n))
+            || (a->isClassified() && b->isClassified() && a->getNodeKind(n) != b->getNodeKind(n)))
+        {
+            mismatch("Node", a->getNodeID(n));
+        }
+    }
+
+    int numOfLinks = static_cast<int>(a->getNumOfLinks());
+    for (int l = 0; l < numOfLinks; l++)
+    {
+        Road* roadA = a->getLinkRoad(l);
+        Road* roadB = b->getLinkRoad(l);
+        bool same = a->getLinkID(l) == b->getLinkID(l) && a->getLinkStartNode(l) == b->getLinkStartNode(l) && a->getLinkEndNode(l) == b->getLinkEndNode(l)
+            && a->getLinkLength(l) == b->getLinkLength(l) && a->getLinkDirection(l) == b->getLinkDirection(l) && a->getOppositeLink(l) == b->getOppositeLink(l)
+            && ((roadA == nullptr) ? -1 : roadA->getID()) == ((roadB == nullptr) ? -1 : roadB->getID());
+        for (int list = 0; same && list < GraphStore::numOfNeighbourLists; list++)
+        {
+            same = sameIndices(a->getNeighbourLinks(l, list), b->getNeighbourLinks(l, list));
+        }
+        if (!same)
+        {
+            mismatch("Link", a->getLinkID(l));
+        }
+    }
+
+    RoadMap* roadsA = built->getRoads();
+    RoadMap* roadsB = restored->getRoads();
+    for (int r = 0; r < static_cast<int>(roadsA->size()); r++)
+    {
+        Road* roadA = roadsA->at(r);
+        Road* roadB = roadsB->at(r);
+        bool same = roadsA->getID(r) == roadsB->getID(r) && roadA->getStartNode()->getID() == roadB->getStartNode()->getID()
+            && roadA->getEndNode()->getID() == roadB->getEndNode()->getID() && roadA->getLength() == roadB->getLength()
+            && roadA->getLinks()->size() == roadB->getLinks()->size();
+        for (size_t i = 0; same && i < roadA->getLinks()->size(); i++)
+        {
+            same = (*roadA->getLinks())[i]->getID() == (*roadB->getLinks())[i]->getID();
+        }
+        if (!same)
+        {
+            mismatch("Road", roadsA->getID(r));
+        }
+    }
+
+    VDSMap* vdsA = built->getVDS();
+    VDSMap* vdsB = restored->getVDS();
+    for (int v = 0; v < static_cast<int>(vdsA->size()); v++)
+    {
+        if (vdsA->getID(v) != vdsB->getID(v) || vdsA->at(v)->getLat() != vdsB->at(v)->getLat() || vdsA->at(v)->getLon() != vdsB->at(v)->getLon())
+        {
+            mismatch("VDS", vdsA->getID(v));
+        }
+    }
+    std::cout << "Snapshot: " << mismatches << " mismatches (of " << numOfNodes << " nodes, " << numOfLinks << " links, " << roadsA->size() << " roads, "
+              << vdsA->size() << " VDS)" << std::endl;
+    return mismatches;
+}
+
+/*!
+ *Function that checks a snapshot against the network built from the csv files; the snapshot is written first if it
+ *has not been built from these files.
+ *@return the number of mismatching elements, or -1 if the snapshot cannot be written or read
+ */
+int verifySnapshot(Network* built, const std::string& networkFilename, const std::string& VDSFilename, const std::string& snapshotFilename,
+                   TimingReport* report = nullptr)
+{
+    double start = omp_get_wtime();
+    NetworkSnapshot snapshot(snapshotFilename);
+    StringVector sourceFilenames = {networkFilename, VDSFilename};
+    if (!snapshot.isUpToDate(sourceFilenames) && !snapshot.write(built, sourceFilenames))
+    {
+        std::cerr << "Cannot write " << snapshotFilename << "\n";
+        return -1;
+    }
+    double readStart = omp_get_wtime();
+    Network restored(networkFilename, VDSFilename);
+    restored.setNumThreads(built->getNumThreads());
+    if (!snapshot.read(&restored))
+    {
+        std::cerr << "Cannot read " << snapshotFilename << "\n";
+        return -1;
+    }
+    double compareStart = omp_get_wtime();
+    int mismatches = compareWithSnapshot(built, &restored);
+    if (report != nullptr)
+    {
+        report->addPhase("snapshot.write", readStart - start);
+        report->addPhase("snapshot.read", compareStart - readStart);
+        report->addPhase("snapshot.verify", omp_get_wtime() - compareStart);
+    }
+    return mismatches;
+}
+
+/*!
+ *Function that writes the adjacency of the links into a file, see AdjacencyExporter for the formats; the csv format
+ *has one line per link, in link ID order, with its ID, its numbers of before and after links and then the IDs of its
+ *before-in, before-out, after-in and after-out links.
+ *@return false if the file cannot be written
+ */
+bool writeAdjacencyMatrix(Network* network, std::string outFilename, AdjacencyFormat format = csvAdjacency, int numThreads = 0, TimingReport* report = nullptr)
+{
+    double start = omp_get_wtime();
+    AdjacencyExporter exporter(network);
+    // The csv format is written from the neighbour lists themselves
+    if (format != csvAdjacency)
+    {
+        exporter.buildLinkAdjacency(numThreads);
+    }
+    double writeStart = omp_get_wtime();
+    bool written = exporter.write(outFilename, format);
+    if (report != nullptr)
+    {
+        if (format != csvAdjacency)
+        {
+            report->addPhase("adjacency.build", writeStart - start);
+            report->setParameter("nonZeros", std::to_string(exporter.getNumOfNonZeros()));
+        }
+        report->addPhase("write", omp_get_wtime() - writeStart);
+    }
+    if (!written)
+    {
+        std::cerr << "Cannot write " << outFilename << "\n";
+    }
+    return written;
+}
+
+/*!
+ *Function that writes the adjacency of the roads into a file, see AdjacencyExporter for the formats.
+ *@param linkOfVDS if given, only the roads of the matched VDS are written
+ *@return false if the file cannot be written
+ */
+bool writeRoadAdjacencyMatrix(Network* network, std::string outFilename, AdjacencyFormat format, const std::vector<int>* linkOfVDS, int numThreads,
+                              TimingReport* report = nullptr)
+{
+    double start = omp_get_wtime();
+    AdjacencyExporter exporter(network);
+    exporter.buildRoadAdjacency(linkOfVDS, numThreads);
+    double writeStart = omp_get_wtime();
+    bool written = exporter.write(outFilename, format);
+    if (report != nullptr)
+    {
+        report->addPhase("adjacency.build", writeStart - start);
+        report->setParameter("roads", std::to_string(exporter.getNumOfRows()));
+        report->setParameter("nonZeros", std::to_string(exporter.getNumOfNonZeros()));
+        report->addPhase("write", omp_get_wtime() - writeStart);
+    }
+    if (!written)
+    {
+        std::cerr << "Cannot write " << outFilename << "\n";
+    }
+    return written;
+}
+
+/*!
+ *Function that serves matching requests until the input ends (or, for a socket, forever).
+ *@param socketPath the Unix socket to listen on, "-" to read VDS lines from stdin
+ *@return false if the socket cannot be set up
+ */
+bool serveMatchingRequests(Network* network, std::string socketPath)
+{
+    MatchingService service(network);
+    service.start();
+    if (socketPath == "-")
+    {
+        // The answers are the only output on stdout from here on
+        service.serveStream(std::cin, std::cout);
+        std::cerr << "Answered " << service.getNumOfRequests() << " requests, mean matching time: " << service.getMeanMatchingTime() << " s" << std::endl;
+        return true;
+    }
+    return service.serveSocket(socketPath);
 }
 
-int main()
+/*!
+ *Function that asks for the task and its parameters on stdin and runs it on the network next to the executable.
+ *@return the exit status of the program
+ */
+int runInteractive()
 {
     Network* network = loadNetwork();
+    if (network == nullptr)
+    {
+        return 1;
+    }
+    int exitStatus = 0;
     int choice1 = 0;
-    std::cout << "Match VDS to roads (1) or check network's info (2) or create adjacency matrix of graph (3)?\n";
+    std::cout << "Match VDS to roads (1) or check network's info (2) or create adjacency matrix of graph (3) or serve matching requests (4)?\n";
     std::cin >> choice1;
 
     if (choice1 == 1)
     {
         std::string outFilename = getExecutablePathAndMatchItWithFilename("VDS_Roads");
         int choice2 = 0;
-        std::cout << "Method 1 (Naive/Greedy) or 2 (PIC)?\n";
+        std::cout << "Method 1 (Naive/Greedy) or 2 (PIC) or 3 (R-tree) or 4 (R-tree, k nearest candidate links) or 5 (check 2 and 3 against 1)?\n";
         std::cin >> choice2;
 
         if (choice2 == 1)
         {
-            matchVDSToRoads_Greedy(network, outFilename);
+            int numThreads = 1;
+            std::cout << "Give number of threads\n";
+            std::cin >> numThreads;
+            if (!matchVDSToRoads_Greedy(network, outFilename, numThreads))
+            {
+                exitStatus = 1;
+            }
         }
         else if (choice2 == 2)
         {
@@ -192,113 +607,500 @@ int main()
             int numThreads = 1;
 
             // User input
-            std::cout << "Give the number by which the maximum link length will be divided\n";
+            std::cout << "Give the number by which the maximum link length will be divided (0 to size the cells automatically)\n";
             std::cin >> divideWith;
             std::cout << "Give number of threads\n";
             std::cin >> numThreads;
 
-            double dimension = maxLengthOfLink / divideWith; // the most crucial point, determine the size of the cells in the grid
-            matchVDSToRoads_PIC(network, dimension, outFilename, numThreads);
+            double dimension = chooseCellSize(network, maxLengthOfLink, divideWith, numThreads); // the most crucial point, determine the size of the cells in the grid
+            if (!matchVDSToRoads_PIC(network, dimension, outFilename, numThreads))
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (choice2 == 3)
+        {
+            int numThreads = 1;
+            std::cout << "Give number of threads\n";
+            std::cin >> numThreads;
+            if (!matchVDSToRoads_RTree(network, outFilename, numThreads))
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (choice2 == 4)
+        {
+            int k = 1;
+            double maxDistance = 0.0;
+            int numThreads = 1;
+            std::cout << "Give number of candidate links per VDS\n";
+            std::cin >> k;
+            std::cout << "Give maximum distance of a candidate link (0 for no limit)\n";
+            std::cin >> maxDistance;
+            std::cout << "Give number of threads\n";
+            std::cin >> numThreads;
+            if (maxDistance <= 0.0)
+            {
+                maxDistance = std::numeric_limits<double>::infinity();
+            }
+            if (!matchVDSToLinkCandidates_RTree(network, getExecutablePathAndMatchItWithFilename("VDS_Candidates"), std::max(k, 0), maxDistance, numThreads))
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (choice2 == 5)
+        {
+            double minLengthOfLink = 0.0;
+            double maxLengthOfLink = 0.0;
+            double meanLengthOfLink = 0.0;
+            network->findMinMaxMeanLengthOfLinks(minLengthOfLink, maxLengthOfLink, meanLengthOfLink);
+            double divideWith = 0.0;
+            int numThreads = 1;
+            std::cout << "Give the number by which the maximum link length will be divided (0 to size the cells automatically)\n";
+            std::cin >> divideWith;
+            std::cout << "Give number of threads\n";
+            std::cin >> numThreads;
+            // A non-zero exit status tells a script that a matcher disagrees with the oracle
+            if (verifyMatchersAgainstGreedy(network, chooseCellSize(network, maxLengthOfLink, divideWith, numThreads), numThreads) > 0)
+            {
+                exitStatus = 1;
+            }
         }
     }
     else if (choice1 == 2)
     {
-        double minLon = -1.0;
-        double maxLon = -1.0;
-        double minLat = -1.0;
-        double maxLat = -1.0;
-        double minLengthOfLink = -1.0;
-        double maxLengthOfLink = -1.0;
-        double meanLengthOfLink = -1.0;
-        double minLengthOfRoad = -1.0;
-        double maxLengthOfRoad = -1.0;
-        double meanLengthOfRoad = -1.0;
-
-        network->setPosLimits();
-        network->getMinMaxPosCoords(minLon, maxLon, minLat, maxLat);
-        network->findMinMaxMeanLengthOfLinks(minLengthOfLink, maxLengthOfLink, meanLengthOfLink);
-        network->findMinMaxMeanLengthOfRoads(minLengthOfRoad, maxLengthOfRoad, meanLengthOfRoad);
-        size_t numOfNodes = network->getNumOfNodes();
-        size_t numOfLinks = network->getNumOfLinks();
-        size_t numOfRoads = network->getNumOfRoads();
-        size_t numOfVDS = network->getNumOfVDS();
-        double lonSize = maxLon - minLon;
-        double latSize = maxLat - minLat;
-        double meanNumOfLinksPerRoad = network->getMeanNumOfLinksPerRoad();
-
-        std::cout << "Network info:\n";
-        std::cout << "minLat: " << minLat << std::endl;
-        std::cout << "minLon: " << minLon << std::endl;
-
-        std::cout << "maxLat: " << maxLat << std::endl;
-        std::cout << "maxLon: " << maxLon << std::endl;
-        
-        std::cout << "latSize: " << latSize << std::endl;
-        std::cout << "lonSize: " << lonSize << std::endl;
-        
-        std::cout << "Nodes: " << numOfNodes << std::endl;
-        std::cout << "Links: " << numOfLinks << std::endl;
-        std::cout << "Roads: " << numOfRoads << std::endl;
-        std::cout << "Mean num of links per road: " << meanNumOfLinksPerRoad << std::endl;
-        std::cout << "VDS: " << numOfVDS << std::endl;
-
-        std::cout << "Min link length: " << minLengthOfLink << std::endl;
-        std::cout << "Max link length: " << maxLengthOfLink << std::endl;
-        std::cout << "Mean link length: " << meanLengthOfLink << std::endl;
- 
-        std::cout << "Min road length: " << minLengthOfRoad << std::endl;
-        std::cout << "Max road length: " << maxLengthOfRoad << std::endl;
-        std::cout << "Mean road length: " << meanLengthOfRoad << std::endl;
+        printNetworkInfo(network);
     }
     else if (choice1 == 3)
     {
-        std::string outFilename = getExecutablePathAndMatchItWithFilename("graph_adjacency_matrix.csv");
-        std::ofstream out(outFilename);
-        LinkMap* links = network->getLinks();
-        for (LinkMap::iterator linkIt = links->begin(); linkIt != links->end(); ++linkIt)
+        if (!writeAdjacencyMatrix(network, getExecutablePathAndMatchItWithFilename("graph_adjacency_matrix.csv")))
         {
-            out << linkIt->first;
+            exitStatus = 1;
+        }
+    } 
+
+    else if (choice1 == 4)
+    {
+        std::string socketPath = "-";
+        std::cout << "Give path of Unix socket to listen on (- to read VDS lines from stdin)\n" << std::flush;
+        std::cin >> socketPath;
+        if (!serveMatchingRequests(network, socketPath))
+        {
+            exitStatus = 1;
+        }
+    }
+
+    delete network;
+    return exitStatus;
+}
 
-            size_t numOfBeforeInLinks = linkIt->second->getNumOfBeforeInLinks();
-            size_t numOfBeforeOutLinks = linkIt->second->getNumOfBeforeOutLinks();
-            size_t numOfBeforeLinks = numOfBeforeInLinks + numOfBeforeOutLinks;
-            out << "," << numOfBeforeLinks;
+/*! The options of the command line, with their defaults */
+struct CommandLineOptions
+{
+    std::string command;
+    std::string networkFilename;
+    std::string VDSFilename;
+    /*! Empty: the snapshot is not used */
+    std::string snapshotFilename;
+    /*! Empty: no snapshot is checked against the csv files */
+    std::string verifiedSnapshotFilename;
+    std::string outFilename;
+    /*! Empty: no timing report */
+    std::string timingsFilename;
+    std::string method = "pic";
+    /*! The format of the adjacency matrix: csv, csr, npz or mtx */
+    std::string format = "csv";
+    /*! The rows of the adjacency matrix: links, roads or matched-roads */
+    std::string level = "links";
+    /*! The methods of a benchmark, comma-separated */
+    std::string methods = "greedy,pic,rtree";
+    std::string socketPath = "-";
+    int numThreads = 0;
+    double divideWith = 0.0;
+    int k = 1;
+    double maxDistance = 0.0;
+    int repeat = 1;
+    /*! The parameters of a synthetic network */
+    SyntheticNetwork synthetic;
+};
 
-            size_t numOfAfterInLinks = linkIt->second->getNumOfAfterInLinks();
-            size_t numOfAfterOutLinks = linkIt->second->getNumOfAfterOutLinks();
-            size_t numOfAfterLinks = numOfAfterInLinks + numOfAfterOutLinks;
-            out << "," << numOfAfterLinks;
+void printUsage(std::ostream& out)
+{
+    out << "Usage: createGraph.out                            (interactive mode, files next to the executable)\n"
+        << "       createGraph.out <command> --network <csv> --vds <csv> [options]\n"
+        << "Commands:\n"
+        << "  match       map-match the VDS (--method greedy|pic|rtree|candidates|verify, --output <file>)\n"
+        << "  info        print the network's info; with --verify-snapshot <file>, also check that the snapshot restores\n"
+        << "              exactly the network built from the csv files (writing it first if it is stale)\n"
+        << "  adjacency   write the adjacency matrix (--output <file>, --format csv|csr|npz|mtx)\n"
+        << "              of the links, of the roads or of the roads of the VDS matched by --method (--level links|roads|matched-roads)\n"
+        << "  bench       time the matchers without writing their results (--methods greedy,pic,rtree, --repeat <n>)\n"
+        << "  serve       serve matching requests (--socket <path>, - for stdin)\n"
+        << "  generate    write a synthetic network and VDS into the --network and --vds files\n"
+        << "              (--seed <n>, --cities <n>, --city-size <n>, --skew <x>, --freeways <n>, --spacing <x>, --num-vds <n>)\n"
+        << "Options:\n"
+        << "  --snapshot <file>      keep the built network in a snapshot (rebuilt when a csv file changes)\n"
+        << "  --threads <n>          number of threads, 0 for all (default 0)\n"
+        << "  --divide-with <x>      cell size of PIC: maximum link length / x, 0 to size the cells automatically (default 0)\n"
+        << "  --k <n>                candidate links per VDS (default 1)\n"
+        << "  --max-distance <x>     maximum distance of a candidate link, 0 for no limit (default 0)\n"
+        << "  --timings <file>       write the time of every phase as JSON, - for stdout (the progress messages go to stderr then)\n";
+}
 
-            LinkMap* beforeInLinks = linkIt->second->getBeforeInLinks();
-            for (LinkMap::iterator it = beforeInLinks->begin(); it != beforeInLinks->end(); ++it)
+/*!
+ *Function that parses the command line.
+ *@return false if an option is unknown, misses its value or has an invalid value
+ */
+bool parseCommandLine(int argc, char** argv, CommandLineOptions& options)
+{
+    options.command = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value of " << option << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        try
+        {
+            if (option == "--network") options.networkFilename = value;
+            else if (option == "--vds") options.VDSFilename = value;
+            else if (option == "--snapshot") options.snapshotFilename = value;
+            else if (option == "--verify-snapshot") options.verifiedSnapshotFilename = value;
+            else if (option == "--output") options.outFilename = value;
+            else if (option == "--timings") options.timingsFilename = value;
+            else if (option == "--method") options.method = value;
+            else if (option == "--format") options.format = value;
+            else if (option == "--level") options.level = value;
+            else if (option == "--methods") options.methods = value;
+            else if (option == "--socket") options.socketPath = value;
+            else if (option == "--threads") options.numThreads = std::stoi(value);
+            else if (option == "--divide-with") options.divideWith = std::stod(value);
+            else if (option == "--k") options.k = std::stoi(value);
+            else if (option == "--max-distance") options.maxDistance = std::stod(value);
+            else if (option == "--repeat") options.repeat = std::stoi(value);
+            else if (option == "--seed") options.synthetic.setSeed(static_cast<unsigned int>(std::stoul(value)));
+            else if (option == "--cities") options.synthetic.setNumOfCities(std::stoi(value));
+            else if (option == "--city-size") options.synthetic.setCitySize(std::stoi(value));
+            else if (option == "--skew") options.synthetic.setSkew(std::stod(value));
+            else if (option == "--freeways") options.synthetic.setNumOfFreewaysPerCity(std::stoi(value));
+            else if (option == "--spacing") options.synthetic.setSpacing(std::stod(value));
+            else if (option == "--num-vds") options.synthetic.setNumOfVDS(std::stoi(value));
+            else
             {
-                out << "," << it->first;
+                std::cerr << "Unknown option " << option << "\n";
+                return false;
             }
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "Invalid value of " << option << ": " << value << "\n";
+            return false;
+        }
+    }
+    AdjacencyFormat format;
+    if (!AdjacencyExporter::parseFormat(options.format, format))
+    {
+        std::cerr << "Unknown format " << options.format << "\n";
+        return false;
+    }
+    // The answers of the service and the timings cannot share stdout
+    if (options.command == "serve" && options.socketPath == "-" && options.timingsFilename == "-")
+    {
+        std::cerr << "--timings - cannot be combined with serve --socket -\n";
+        return false;
+    }
+    // The network to check the snapshot against must be built from the csv files
+    if (!options.verifiedSnapshotFilename.empty() && !options.snapshotFilename.empty())
+    {
+        std::cerr << "--verify-snapshot cannot be combined with --snapshot\n";
+        return false;
+    }
+    if (options.level != "links" && options.level != "roads" && options.level != "matched-roads")
+    {
+        std::cerr << "Unknown level " << options.level << "\n";
+        return false;
+    }
+    if (options.networkFilename.empty() || options.VDSFilename.empty())
+    {
+        std::cerr << "The network and the VDS files must be given\n";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ *Function that writes a synthetic network and its VDS.
+ *@return the exit status of the program
+ */
+int generateNetwork(const CommandLineOptions& options, TimingReport& report)
+{
+    SyntheticNetwork synthetic = options.synthetic;
+    if (synthetic.getNumOfCities() < 1 || synthetic.getCitySize() < 1 || synthetic.getNumOfFreewaysPerCity() < 0 || synthetic.getSpacing() <= 0.0)
+    {
+        std::cerr << "Invalid parameters of the synthetic network\n";
+        return 2;
+    }
+    report.setParameter("seed", std::to_string(synthetic.getSeed()));
+    report.setParameter("cities", std::to_string(synthetic.getNumOfCities()));
+    report.setParameter("citySize", std::to_string(synthetic.getCitySize()));
+    report.setParameter("skew", std::to_string(synthetic.getSkew()));
+    report.setParameter("freeways", std::to_string(synthetic.getNumOfFreewaysPerCity()));
+    report.setParameter("spacing", std::to_string(synthetic.getSpacing()));
+    double start = omp_get_wtime();
+    if (!synthetic.write(options.networkFilename, options.VDSFilename))
+    {
+        std::cerr << "Cannot write " << options.networkFilename << " or " << options.VDSFilename << "\n";
+        return 1;
+    }
+    report.addPhase("generate", omp_get_wtime() - start);
+    report.setParameter("nodes", std::to_string(synthetic.getNumOfWrittenNodes()));
+    report.setParameter("links", std::to_string(synthetic.getNumOfWrittenLinks()));
+    report.setParameter("VDS", std::to_string(synthetic.getNumOfWrittenVDS()));
+    std::cout << "Nodes: " << synthetic.getNumOfWrittenNodes() << std::endl;
+    std::cout << "Links: " << synthetic.getNumOfWrittenLinks() << std::endl;
+    std::cout << "VDS: " << synthetic.getNumOfWrittenVDS() << std::endl;
+    return 0;
+}
+
+/*!
+ *Function that finds the link of every VDS with one of the matchers.
+ *@return false if the method is unknown
+ */
+bool findLinksOfVDS(Network* network, const std::string& method, double divideWith, double maxLengthOfLink, int numThreads, std::vector<int>& linkOfVDS,
+                    TimingReport& report)
+{
+    if (method == "greedy")
+    {
+        findLinksOfVDS_Greedy(network, numThreads, linkOfVDS, &report);
+    }
+    else if (method == "pic")
+    {
+        double dimension = chooseCellSize(network, maxLengthOfLink, divideWith, numThreads, &report);
+        report.setParameter("dimension", std::to_string(dimension));
+        findLinksOfVDS_PIC(network, dimension, numThreads, linkOfVDS, &report);
+    }
+    else if (method == "rtree")
+    {
+        findLinksOfVDS_RTree(network, numThreads, linkOfVDS, &report);
+    }
+    else
+    {
+        std::cerr << "Unknown method " << method << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ *Function that runs a command on a loaded network; the timing report is written by runCommand().
+ *@return the exit status of the program
+ */
+int runNetworkCommand(const CommandLineOptions& options, TimingReport& report)
+{
+    const std::string& command = options.command;
+    int numThreads = (options.numThreads > 0) ? options.numThreads : omp_get_max_threads();
+    report.setParameter("network", options.networkFilename);
+    report.setParameter("vds", options.VDSFilename);
+    report.setParameter("threads", std::to_string(numThreads));
+    Network* network = loadNetwork(options.networkFilename, options.VDSFilename, options.snapshotFilename, numThreads, &report);
+    if (network == nullptr)
+    {
+        return 1;
+    }
+    report.setParameter("links", std::to_string(network->getNumOfLinks()));
+    report.setParameter("VDS", std::to_string(network->getNumOfVDS()));
 
-            LinkMap* beforeOutLinks = linkIt->second->getBeforeOutLinks();
-            for (LinkMap::iterator it = beforeOutLinks->begin(); it != beforeOutLinks->end(); ++it)
+    double minLengthOfLink = 0.0;
+    double maxLengthOfLink = 0.0;
+    double meanLengthOfLink = 0.0;
+    network->findMinMaxMeanLengthOfLinks(minLengthOfLink, maxLengthOfLink, meanLengthOfLink);
+    int exitStatus = 0;
+
+    if (command == "match")
+    {
+        report.setParameter("method", options.method);
+        const std::string& method = options.method;
+        if (method == "greedy")
+        {
+            if (!matchVDSToRoads_Greedy(network, options.outFilename, numThreads, &report))
             {
-                out << "," << it->first;
+                exitStatus = 1;
             }
-
-            LinkMap* afterInLinks = linkIt->second->getAfterInLinks();
-            for (LinkMap::iterator it = afterInLinks->begin(); it != afterInLinks->end(); ++it)
+        }
+        else if (method == "pic" || method == "verify")
+        {
+            double dimension = chooseCellSize(network, maxLengthOfLink, options.divideWith, numThreads, &report);
+            report.setParameter("dimension", std::to_string(dimension));
+            if (method == "pic")
             {
-                out << "," << it->first;
+                if (!matchVDSToRoads_PIC(network, dimension, options.outFilename, numThreads, &report))
+                {
+                    exitStatus = 1;
+                }
             }
-
-            LinkMap* afterOutLinks = linkIt->second->getAfterOutLinks();
-            for (LinkMap::iterator it = afterOutLinks->begin(); it != afterOutLinks->end(); ++it)
+            else if (verifyMatchersAgainstGreedy(network, dimension, numThreads, &report) > 0)
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (method == "rtree")
+        {
+            if (!matchVDSToRoads_RTree(network, options.outFilename, numThreads, &report))
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (method == "candidates")
+        {
+            double maxDistance = (options.maxDistance > 0.0) ? options.maxDistance : std::numeric_limits<double>::infinity();
+            report.setParameter("k", std::to_string(options.k));
+            report.setParameter("maxDistance", std::to_string(options.maxDistance));
+            if (!matchVDSToLinkCandidates_RTree(network, options.outFilename, std::max(options.k, 0), maxDistance, numThreads, &report))
+            {
+                exitStatus = 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown method " << method << "\n";
+            exitStatus = 2;
+        }
+    }
+    else if (command == "info")
+    {
+        printNetworkInfo(network);
+        if (!options.verifiedSnapshotFilename.empty())
+        {
+            report.setParameter("verifiedSnapshot", options.verifiedSnapshotFilename);
+            if (verifySnapshot(network, options.networkFilename, options.VDSFilename, options.verifiedSnapshotFilename, &report) != 0)
+            {
+                exitStatus = 1;
+            }
+        }
+    }
+    else if (command == "adjacency")
+    {
+        report.setParameter("format", options.format);
+        report.setParameter("level", options.level);
+        AdjacencyFormat format;
+        AdjacencyExporter::parseFormat(options.format, format);
+        if (options.level == "links")
+        {
+            if (!writeAdjacencyMatrix(network, options.outFilename, format, numThreads, &report))
+            {
+                exitStatus = 1;
+            }
+        }
+        else if (options.level == "roads")
+        {
+            if (!writeRoadAdjacencyMatrix(network, options.outFilename, format, nullptr, numThreads, &report))
             {
-                out << "," << it->first;
+                exitStatus = 1;
             }
+        }
+        else
+        {
+            report.setParameter("method", options.method);
+            std::vector<int> linkOfVDS;
+            if (!findLinksOfVDS(network, options.method, options.divideWith, maxLengthOfLink, numThreads, linkOfVDS, report))
+            {
+                exitStatus = 2;
+            }
+            else if (!writeRoadAdjacencyMatrix(network, options.outFilename, format, &linkOfVDS, numThreads, &report))
+            {
+                exitStatus = 1;
+            }
+        }
+    }
+    else if (command == "bench")
+    {
+        report.setParameter("methods", options.methods);
+        report.setParameter("repeat", std::to_string(options.repeat));
+        std::vector<int> linkOfVDS;
+        std::stringstream methods(options.methods);
+        std::string method;
+        while (exitStatus == 0 && std::getline(methods, method, ','))
+        {
+            for (int run = 0; run < options.repeat; run++)
+            {
+                if (!findLinksOfVDS(network, method, options.divideWith, maxLengthOfLink, numThreads, linkOfVDS, report))
+                {
+                    exitStatus = 2;
+                    break;
+                }
+            }
+        }
+    }
+    else if (command == "serve")
+    {
+        if (!serveMatchingRequests(network, options.socketPath))
+        {
+            exitStatus = 1;
+        }
+    }
+    delete network;
+    return exitStatus;
+}
 
-            out << std::endl;
+/*!
+ *Function that runs a command of the command line.
+ *@return the exit status of the program: 0 on success, 1 if the command fails, 2 if the command line is invalid
+ */
+int runCommand(const CommandLineOptions& options)
+{
+    const std::string& command = options.command;
+    bool writesOutput = (command == "match" && options.method != "verify") || command == "adjacency";
+    if (command != "match" && command != "info" && command != "adjacency" && command != "bench" && command != "serve" && command != "generate")
+    {
+        std::cerr << "Unknown command " << command << "\n";
+        return 2;
+    }
+    if (writesOutput && options.outFilename.empty())
+    {
+        std::cerr << "The output file must be given with --output\n";
+        return 2;
+    }
+    TimingReport report(command);
+    int exitStatus = 0;
+    double start = omp_get_wtime();
+    // The timings on stdout must be the only thing there, the progress messages go to stderr meanwhile
+    std::streambuf* coutBuffer = (options.timingsFilename == "-") ? std::cout.rdbuf(std::cerr.rdbuf()) : nullptr;
+    exitStatus = (command == "generate") ? generateNetwork(options, report) : runNetworkCommand(options, report);
+    if (coutBuffer != nullptr)
+    {
+        std::cout.rdbuf(coutBuffer);
+    }
+    report.setTotalSeconds(omp_get_wtime() - start);
 
-        }
-        out.close();
-    } 
+    report.setProfile(Profiler::getPhases());
+    if (!options.timingsFilename.empty() && !report.write(options.timingsFilename))
+    {
+        std::cerr << "Cannot write " << options.timingsFilename << "\n";
+        exitStatus = 1;
+    }
+    return exitStatus;
+}
 
-    delete network;
-    return 0;
-}
\ No newline at end of file
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        return runInteractive();
+    }
+    std::string command = argv[1];
+    if (command == "help" || command == "--help" || command == "-h")
+    {
+        printUsage(std::cout);
+        return 0;
+    }
+    CommandLineOptions options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage(std::cerr);
+        return 2;
+    }
+    return runCommand(options);
+}